@@ -7,11 +7,68 @@
 #   ./run_vosk_server.sh --save-audio # Enable audio recording to WAV files
 #   SAVE_AUDIO=true ./run_vosk_server.sh  # Alternative way to enable audio recording
 #
+# Offline batch transcription (no server) runs the executable directly:
+#   build/vosk_asr_ws batch [--list FILE] [--output DIR] [--chunk-sec N] [--threads N] <wav|dir>...
+#
+# The server listens on port 9000 immediately and loads the model in the background. Until the
+# model is ready, WebSocket clients are closed with 1013 (try again later). Probes on the same port:
+#   GET /healthz - 200 while the process is up (liveness)
+#   GET /readyz  - 200 once the model is loaded, 503 while loading or if loading failed (readiness)
+#
+# Gateways can carry many calls on one connection: send {"type":"mux_open","streamId":N,...metadata}
+# per call, then binary frames prefixed with the u32 little-endian stream ID. Transcripts carry
+# "stream_id"; {"type":"mux_close","streamId":N} ends a call.
+#
 # Environment Variables:
 #   LOG_FOLDER       - Directory for log files (default: current directory)
 #   RECORDING_FOLDER - Directory for audio recordings (default: current directory)
 #   SAVE_AUDIO       - Enable audio recording (true/false)
 #   VOSK_MODEL_PATH  - Path to Vosk model
+#   MODEL_PREFETCH   - Read model files into the page cache in parallel before loading (default: 1)
+#   AUDIO_RING_SECONDS - Keep the last N seconds of each call in memory and write them to
+#                      RECORDING_FOLDER only on a trigger (default: 0 = off)
+#   AUDIO_TRIGGER_KEYWORDS - Comma-separated words in a final transcript that trigger a dump
+#   DECODE_SLACK_MS  - Decode budget past a frame's real-time end used as its EDF deadline (default: 200)
+#   FINAL_SILENCE_MS - Force a final once speech is followed by this much trailing silence, ahead of
+#                      Vosk's endpointer (default: 0 = off; per session via metadata finalAfterSilenceMs)
+#   FINAL_SILENCE_RMS - Frame RMS below which audio counts as silence for forced finals (default: 300)
+#                      Metadata may also set endpointerMode (default/short/long/very_long) and
+#                      endpointerStartMax/End/Max seconds when libvosk supports endpointer controls
+#   POOL_MIN_THREADS / POOL_MAX_THREADS - Decode pool bounds (default: 2 / max(4, cores)); POOL_MAX_THREADS
+#                      is also the hard limit for runtime changes (default limit: 4 x max(4, cores))
+#   POOL_TARGET_WAIT_MS - Grow the pool while mean queue wait exceeds this, in proportion to the
+#                      overshoot (up to doubling per interval) (default: 20)
+#   POOL_TUNE_INTERVAL_MS - How often the pool size is re-evaluated (default: 2000)
+#   POOL_AUTOTUNE    - Resize the pool from measured load (default: 1); also settable at runtime
+#                      with {"type":"pool_config", ...}, where an explicit "threads" pins the size
+#                      and turns autotune off
+#   ADMIN_TOKEN      - Shared secret that admin messages (pool_config, tenant_stats, save_audio with
+#                      a callId) must carry as "adminToken"; without it they are refused (default: unset)
+#   TENANT_WEIGHTS   - Decode CPU shares per tenant, e.g. "acme=4,globex=1" (unlisted tenants: 1).
+#                      Sessions name their tenant with "tenant" in the metadata; per-tenant CPU,
+#                      queue wait and decode lag are reported by {"type":"tenant_stats"}, with
+#                      untagged sessions under tenant ""
+#   TENANT_MAX_SESSIONS - Concurrent sessions allowed per tenant (default: 0 = unlimited)
+#   TENANT_SESSION_CAPS - Per-tenant overrides of TENANT_MAX_SESSIONS, e.g. "acme=500"
+#   UNIX_SOCKET_PATH - Also accept sessions on this Unix domain socket using length-prefixed
+#                      frames ([u8 type][u32 LE length][payload]; type 1 = JSON text, 2 = PCM audio)
+#   RTP_PORT         - Also accept forked RTP (PCMU/PCMA/L16) on this UDP port (default: 0 = off).
+#                      A control session claims a stream by sending rtpSsrc and/or rtpSourcePort
+#                      (plus optional rtpCodec, rtpRate for dynamic payload types) in its metadata
+#                      or in {"type":"rtp_bind", ...}; transcripts go back on that session
+#   RTP_JITTER_PACKETS - Packets held per RTP stream for reordering (default: 3)
+#   IDLE_TIMEOUT_SEC - Finalize and close sessions with no audio for this long (default: 0 = off;
+#                      recommended: 300 where clients reconnect; mod_audio_stream does not, so
+#                      long holds would end the stream)
+#   MEMORY_CEILING_MB - Reap the longest-idle sessions while RSS exceeds this (default: 0 = off)
+#   MEMORY_REAP_MIN_IDLE_SEC - Minimum idle time before a session can be reaped for memory (default: 10)
+#   BATCH_CHUNK_SEC  - Target chunk length for batch mode silence splitting (default: 30)
+#   TRANSCRIPT_SINK_FOLDER - Append final transcripts to segment files here (default: disabled)
+#   TRANSCRIPT_SINK_FORMAT - Segment format: jsonl or binary (default: jsonl)
+#   TRANSCRIPT_SINK_SEGMENT_MB - Rotate segments after this size (default: 64)
+#   TRANSCRIPT_SINK_FLUSH_MS - Group-commit window for finals (default: 50)
+#   TRANSCRIPT_SINK_FSYNC - fdatasync each committed batch (default: 1)
+#   TRANSCRIPT_SINK_SOCKET - Unix socket path streaming committed finals as JSONL (default: disabled)
 
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 BUILD_DIR="${SCRIPT_DIR}/build"
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <vector>
 #include <cstring>
+#include <cerrno>
 #include <memory>
 #include <mutex>
 #include <map>
@@ -10,22 +11,80 @@
 #include <sstream>
 #include <thread>
 #include <queue>
+#include <deque>
 #include <condition_variable>
 #include <functional>
 #include <random>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <array>
+#include <unordered_map>
+#include <unistd.h>
+#include <dlfcn.h>
 #include "Uuid.h"
+#include "TranscriptSink.h"
+#include "AudioRingBuffer.h"
+#include "MappedWav.h"
+#include "SilenceSplitter.h"
+#include "ShardedMap.h"
+#include "ModelPrefetch.h"
+#include "AudioCodec.h"
+#include "RtpJitterBuffer.h"
+#include <future>
+#include <filesystem>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
 #include <nlohmann/json.hpp>
 #include <vosk_api.h>
 
 using json = nlohmann::json;
-typedef websocketpp::server<websocketpp::config::asio> server;
-typedef server::message_ptr message_ptr;
 using websocketpp::connection_hdl;
 
+struct ConnectionState;
+
+// Per-connection user data, attached to every websocketpp connection object
+// so frames find their session through the handle without a shared lookup.
+// Only touched from websocketpp handlers and timers (the io_service thread).
+struct ConnectionData {
+    std::shared_ptr<ConnectionState> session;
+};
+
+// Stock asio config with ConnectionData as the connection base
+struct asr_config : public websocketpp::config::asio {
+    typedef websocketpp::config::asio core;
+    
+    typedef core::concurrency_type concurrency_type;
+    typedef core::request_type request_type;
+    typedef core::response_type response_type;
+    typedef core::message_type message_type;
+    typedef core::con_msg_manager_type con_msg_manager_type;
+    typedef core::endpoint_msg_manager_type endpoint_msg_manager_type;
+    typedef core::alog_type alog_type;
+    typedef core::elog_type elog_type;
+    typedef core::rng_type rng_type;
+    
+    struct transport_config : public core::transport_config {
+        typedef core::concurrency_type concurrency_type;
+        typedef core::alog_type alog_type;
+        typedef core::elog_type elog_type;
+        typedef core::request_type request_type;
+        typedef core::response_type response_type;
+        typedef websocketpp::transport::asio::basic_socket::endpoint socket_type;
+    };
+    typedef websocketpp::transport::asio::endpoint<transport_config> transport_type;
+    
+    typedef ConnectionData connection_base;
+};
+
+typedef websocketpp::server<asr_config> server;
+typedef server::message_ptr message_ptr;
+
 constexpr int PORT = 9000;
 constexpr int SAMPLE_RATE = 16000;  // Vosk model expects 16kHz
 
@@ -33,10 +92,32 @@ constexpr int SAMPLE_RATE = 16000;  // Vosk model expects 16kHz
 bool g_save_audio = false;  // Set from SAVE_AUDIO environment variable
 std::string g_log_folder = ".";  // Set from LOG_FOLDER environment variable
 std::string g_recording_folder = ".";  // Set from RECORDING_FOLDER environment variable
+std::string g_unix_socket_path;  // Set from UNIX_SOCKET_PATH environment variable (empty = disabled)
+std::string g_admin_token;  // Set from ADMIN_TOKEN: required on admin messages (empty = admin messages refused)
+long g_rtp_port = 0;  // Set from RTP_PORT environment variable (0 = disabled)
+long g_rtp_jitter_packets = 3;  // Set from RTP_JITTER_PACKETS: reorder depth per RTP stream
+long g_audio_ring_seconds = 0;  // Set from AUDIO_RING_SECONDS environment variable (0 = disabled)
+std::vector<std::string> g_audio_trigger_keywords;  // Set from AUDIO_TRIGGER_KEYWORDS (comma-separated)
+long g_final_silence_ms = 0;  // Set from FINAL_SILENCE_MS: default forced-final window (0 = Vosk endpointer only)
+long g_final_silence_rms = 300;  // Set from FINAL_SILENCE_RMS: frames below this level count as silence
+long g_decode_slack_ms = 200;  // Set from DECODE_SLACK_MS: decode budget past a frame's real-time end
+long g_idle_timeout_sec = 0;  // Set from IDLE_TIMEOUT_SEC environment variable (0 = disabled)
+long g_memory_ceiling_mb = 0;  // Set from MEMORY_CEILING_MB environment variable (0 = disabled)
+long g_memory_reap_min_idle_sec = 10;  // Set from MEMORY_REAP_MIN_IDLE_SEC environment variable
+long g_reap_interval_sec = 5;  // How often idle sessions are checked
+
+// Approximate recognizer footprint used for per-session memory accounting.
+// Vosk doesn't expose allocator stats, so we model a fixed per-recognizer cost
+// plus lattice/feature growth for audio decoded since the last final result.
+constexpr size_t RECOGNIZER_BASE_BYTES = 2 * 1024 * 1024;
+constexpr size_t RECOGNIZER_BYTES_PER_AUDIO_SEC = 128 * 1024;
 
 // Global Vosk model (shared across all connections)
 VoskModel* g_vosk_model = nullptr;
+std::atomic<bool> g_model_ready(false);   // Set once g_vosk_model is loaded; sessions are refused until then
+std::atomic<bool> g_model_failed(false);
 std::mutex g_model_mutex;
+int64_t g_process_start_ms = 0;  // steady clock, for startup timing and the liveness probe
 
 #include "GlobalLogger.h"
 
@@ -56,6 +137,36 @@ std::string get_timestamp() {
     return ss.str();
 }
 
+// Helper: Monotonic milliseconds for idle tracking
+int64_t steady_now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Helper: Read a numeric environment variable, falling back to default_value
+long get_env_long(const char* name, long default_value) {
+    const char* value = std::getenv(name);
+    if (!value || strlen(value) == 0) {
+        return default_value;
+    }
+    try {
+        return std::stol(value);
+    } catch (const std::exception&) {
+        std::cerr << "[WARN] Invalid " << name << " value: " << value << ". Using " << default_value << ".\n";
+        return default_value;
+    }
+}
+
+// Helper: Current resident set size of this process (0 if unavailable)
+size_t get_process_rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0, resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
 // Helper: Create directory if it doesn't exist
 bool create_directory(const std::string& path) {
     struct stat st;
@@ -122,9 +233,9 @@ private:
     }
     
 public:
-    WavWriter(const std::string& uuid) : session_uuid(uuid), data_size(0) {
-        // No "audio_" prefix, just UUID.wav
-        std::string basename = uuid + ".wav";
+    WavWriter(const std::string& uuid, const std::string& suffix = "") : session_uuid(uuid), data_size(0) {
+        // No "audio_" prefix, just UUID.wav (UUID-suffix.wav for triggered dumps)
+        std::string basename = uuid + (suffix.empty() ? "" : "-" + suffix) + ".wav";
         // Use recording folder from environment variable
         filename = g_recording_folder + "/" + basename;
         file.open(filename, std::ios::binary | std::ios::out);
@@ -158,56 +269,338 @@ public:
     std::string get_filename() const { return filename; }
 };
 
-// Simple thread pool for offloading Vosk processing
+// Scheduling class for pool tasks. Live calls always run before background
+// (batch/offline, disk dumps) work; within a class, earliest deadline first.
+enum class TaskClass {
+    LIVE = 0,
+    BACKGROUND = 1
+};
+
+// Load sample taken by ThreadPool::sample_stats()
+struct PoolStats {
+    size_t threads;
+    size_t pending;
+    uint64_t tasks;        // Tasks started during the window
+    double avg_wait_ms;    // Mean enqueue-to-start delay
+    double max_wait_ms;
+    double utilization;    // Busy time / (threads * window)
+};
+
+// Per-tenant share of the pool, reported by ThreadPool::tenant_stats()
+struct TenantPoolStats {
+    std::string name;
+    double weight;
+    size_t pending;
+    uint64_t tasks;        // Tasks run since start
+    double cpu_ms;         // Thread CPU time of those tasks
+    double avg_wait_ms;    // Mean enqueue-to-start delay since start
+    double max_wait_ms;    // Since the previous tenant_stats() call
+};
+
+// Thread pool for offloading Vosk processing, scheduled earliest-deadline-first.
+// The number of workers can change at runtime via resize().
+//
+// Tasks belong to a tenant (slot 0 is the default tenant). Live work still
+// runs before background work, but between tenants with work of the same
+// class the pool runs the one with the least weighted CPU time (start-time
+// fair queueing on virtual time); within a tenant, earliest deadline first.
+// A tenant's virtual time advances by each task's thread CPU time divided by
+// its weight, and a tenant that goes idle rejoins at the current virtual
+// time so it can't bank credit.
 class ThreadPool {
 private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    struct Task {
+        TaskClass task_class;
+        int64_t deadline_ms;  // steady clock
+        uint64_t seq;         // FIFO tie-break
+        int64_t enqueued_us;  // steady clock, for queue wait measurement
+        size_t tenant;
+        std::function<void()> fn;
+    };
+    
+    // priority_queue pops the "largest", so order so that it is the most urgent
+    struct TaskOrder {
+        bool operator()(const Task& a, const Task& b) const {
+            if (a.task_class != b.task_class) return a.task_class > b.task_class;
+            if (a.deadline_ms != b.deadline_ms) return a.deadline_ms > b.deadline_ms;
+            return a.seq > b.seq;
+        }
+    };
+    
+    struct Tenant {
+        std::string name;
+        double weight = 1.0;
+        double vtime = 0.0;   // Weighted CPU microseconds
+        std::priority_queue<Task, std::vector<Task>, TaskOrder> tasks;
+        uint64_t tasks_run = 0;
+        int64_t cpu_us = 0;
+        int64_t wait_us = 0;
+        int64_t max_wait_us = 0;
+    };
+    
+    static constexpr size_t MAX_TENANTS = 1024;  // Further tenants share the default slot
+    
+    std::map<size_t, std::thread> workers;
+    std::vector<size_t> exited_workers;  // Retired, waiting to be joined
+    size_t next_worker_id;
+    size_t retire_requests;
+    std::vector<Tenant> tenants;                        // Slots are never removed
+    std::unordered_map<std::string, size_t> tenant_slots;
+    size_t pending_tasks;
+    double virtual_now;                                 // vtime of the latest dispatch
     std::mutex queue_mutex;
     std::condition_variable condition;
+    uint64_t next_seq;
     bool stop;
+    
+    // Measurement window, guarded by queue_mutex except busy_us
+    int64_t window_start_us;
+    uint64_t window_tasks;
+    int64_t window_wait_us;
+    int64_t window_max_wait_us;
+    std::atomic<int64_t> busy_us;
+    
+    static int64_t now_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    static int64_t thread_cpu_us() {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+    
+    // Tenant whose head task runs next. Caller holds queue_mutex; pending_tasks > 0.
+    size_t pick_tenant() const {
+        size_t best = tenants.size();
+        for (size_t i = 0; i < tenants.size(); ++i) {
+            const Tenant& t = tenants[i];
+            if (t.tasks.empty()) continue;
+            if (best == tenants.size()) {
+                best = i;
+                continue;
+            }
+            const Task& head = t.tasks.top();
+            const Task& best_head = tenants[best].tasks.top();
+            if (head.task_class != best_head.task_class) {
+                if (head.task_class < best_head.task_class) best = i;
+            } else if (t.vtime != tenants[best].vtime) {
+                if (t.vtime < tenants[best].vtime) best = i;
+            } else if (TaskOrder()(best_head, head)) {
+                best = i;
+            }
+        }
+        return best;
+    }
+    
+    void worker_loop(size_t id) {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(this->queue_mutex);
+                this->condition.wait(lock, [this] {
+                    return this->stop || this->retire_requests > 0 || this->pending_tasks > 0;
+                });
+                
+                if (this->retire_requests > 0 && !this->stop) {
+                    --this->retire_requests;
+                    this->exited_workers.push_back(id);
+                    return;
+                }
+                if (this->stop && this->pending_tasks == 0) {
+                    return;
+                }
+                
+                Tenant& tenant = this->tenants[pick_tenant()];
+                this->virtual_now = std::max(this->virtual_now, tenant.vtime);
+                
+                // top() is const; fields are moved out just before pop()
+                task = std::move(const_cast<Task&>(tenant.tasks.top()));
+                tenant.tasks.pop();
+                --this->pending_tasks;
+                
+                int64_t wait_us = now_us() - task.enqueued_us;
+                ++this->window_tasks;
+                this->window_wait_us += wait_us;
+                this->window_max_wait_us = std::max(this->window_max_wait_us, wait_us);
+                tenant.wait_us += wait_us;
+                tenant.max_wait_us = std::max(tenant.max_wait_us, wait_us);
+            }
+            int64_t start_us = now_us();
+            int64_t start_cpu_us = thread_cpu_us();
+            task.fn();
+            int64_t cpu_us = thread_cpu_us() - start_cpu_us;
+            busy_us += now_us() - start_us;
+            
+            std::unique_lock<std::mutex> lock(this->queue_mutex);
+            Tenant& tenant = this->tenants[task.tenant];
+            tenant.vtime += static_cast<double>(cpu_us) / tenant.weight;
+            tenant.cpu_us += cpu_us;
+            ++tenant.tasks_run;
+        }
+    }
 
-public:
-    explicit ThreadPool(size_t num_threads) : stop(false) {
-        for (size_t i = 0; i < num_threads; ++i) {
-            workers.emplace_back([this] {
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock, [this] {
-                            return this->stop || !this->tasks.empty();
-                        });
-                        
-                        if (this->stop && this->tasks.empty()) {
-                            return;
-                        }
-                        
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    task();
+    // Join workers that have retired. Caller must not hold queue_mutex.
+    void join_exited() {
+        std::vector<std::thread> finished;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            for (size_t id : exited_workers) {
+                auto it = workers.find(id);
+                if (it != workers.end()) {
+                    finished.push_back(std::move(it->second));
+                    workers.erase(it);
                 }
-            });
+            }
+            exited_workers.clear();
+        }
+        for (std::thread& worker : finished) {
+            if (worker.joinable()) {
+                worker.join();
+            }
         }
     }
 
+public:
+    explicit ThreadPool(size_t num_threads)
+        : next_worker_id(0), retire_requests(0), pending_tasks(0), virtual_now(0.0), next_seq(0), stop(false),
+          window_start_us(now_us()), window_tasks(0), window_wait_us(0), window_max_wait_us(0), busy_us(0) {
+        // Slot 0 serves untagged sessions; named "" so no client tenant can alias it
+        tenants.emplace_back();
+        tenant_slots.emplace("", 0);
+        resize(num_threads);
+    }
+
+    // Run f by deadline_ms (steady clock) within its scheduling class, on
+    // behalf of the tenant slot from tenant_slot()
     template<class F>
-    void enqueue(F&& f) {
+    void enqueue(int64_t deadline_ms, TaskClass task_class, F&& f, size_t tenant = 0) {
         {
             std::unique_lock<std::mutex> lock(queue_mutex);
-            tasks.emplace(std::forward<F>(f));
+            if (tenant >= tenants.size()) tenant = 0;
+            Tenant& t = tenants[tenant];
+            if (t.tasks.empty()) {
+                t.vtime = std::max(t.vtime, virtual_now);
+            }
+            t.tasks.push(Task{task_class, deadline_ms, next_seq++, now_us(), tenant, std::function<void()>(std::forward<F>(f))});
+            ++pending_tasks;
         }
         condition.notify_one();
     }
 
+    // Live work due now
+    template<class F>
+    void enqueue(F&& f) {
+        enqueue(steady_now_ms(), TaskClass::LIVE, std::forward<F>(f));
+    }
+
+    // Grow or shrink to num_threads workers. Shrinking retires idle workers
+    // as they next wake; running tasks are never interrupted.
+    void resize(size_t num_threads) {
+        join_exited();
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (stop) return;
+        size_t current = workers.size() - exited_workers.size() - retire_requests;
+        if (num_threads > current) {
+            size_t add = num_threads - current;
+            size_t cancelled = std::min(add, retire_requests);
+            retire_requests -= cancelled;
+            for (size_t i = cancelled; i < add; ++i) {
+                size_t id = next_worker_id++;
+                workers.emplace(id, std::thread([this, id] { worker_loop(id); }));
+            }
+        } else if (num_threads < current) {
+            retire_requests += current - num_threads;
+            lock.unlock();
+            condition.notify_all();
+        }
+    }
+
+    size_t size() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        return workers.size() - exited_workers.size() - retire_requests;
+    }
+
+    size_t pending() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        return pending_tasks;
+    }
+    
+    // Slot for a tenant key, created on first use ("" is the default tenant)
+    size_t tenant_slot(const std::string& name) {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        auto it = tenant_slots.find(name);
+        if (it != tenant_slots.end()) return it->second;
+        if (tenants.size() >= MAX_TENANTS) return 0;
+        size_t slot = tenants.size();
+        tenants.emplace_back();
+        tenants[slot].name = name;
+        tenants[slot].vtime = virtual_now;
+        tenant_slots.emplace(name, slot);
+        return slot;
+    }
+    
+    void set_tenant_weight(size_t slot, double weight) {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (slot < tenants.size() && weight > 0) {
+            tenants[slot].weight = weight;
+        }
+    }
+    
+    // Cumulative per-tenant usage; resets each tenant's max wait
+    std::vector<TenantPoolStats> tenant_stats() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        std::vector<TenantPoolStats> result;
+        for (Tenant& t : tenants) {
+            TenantPoolStats stats;
+            stats.name = t.name;
+            stats.weight = t.weight;
+            stats.pending = t.tasks.size();
+            stats.tasks = t.tasks_run;
+            stats.cpu_ms = t.cpu_us / 1000.0;
+            stats.avg_wait_ms = t.tasks_run ? t.wait_us / 1000.0 / t.tasks_run : 0.0;
+            stats.max_wait_ms = t.max_wait_us / 1000.0;
+            t.max_wait_us = 0;
+            result.push_back(stats);
+        }
+        return result;
+    }
+
+    // Load since the previous call; starts a new measurement window
+    PoolStats sample_stats() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        int64_t now = now_us();
+        int64_t window_us = std::max<int64_t>(1, now - window_start_us);
+        size_t threads = workers.size() - exited_workers.size() - retire_requests;
+        
+        PoolStats stats;
+        stats.threads = threads;
+        stats.pending = pending_tasks;
+        stats.tasks = window_tasks;
+        stats.avg_wait_ms = window_tasks ? window_wait_us / 1000.0 / window_tasks : 0.0;
+        stats.max_wait_ms = window_max_wait_us / 1000.0;
+        stats.utilization = threads ? static_cast<double>(busy_us.exchange(0)) / (threads * window_us) : 0.0;
+        
+        window_start_us = now;
+        window_tasks = 0;
+        window_wait_us = 0;
+        window_max_wait_us = 0;
+        return stats;
+    }
+
     ~ThreadPool() {
+        std::vector<std::thread> all;
         {
             std::unique_lock<std::mutex> lock(queue_mutex);
             stop = true;
+            for (auto& entry : workers) {
+                all.push_back(std::move(entry.second));
+            }
+            workers.clear();
         }
         condition.notify_all();
-        for (std::thread& worker : workers) {
+        for (std::thread& worker : all) {
             if (worker.joinable()) {
                 worker.join();
             }
@@ -218,6 +611,206 @@ public:
 // Global thread pool for Vosk processing
 std::unique_ptr<ThreadPool> g_thread_pool;
 
+// Runtime-adjustable pool sizing (POOL_* environment variables, "pool_config" message)
+struct PoolTuning {
+    bool autotune = true;
+    size_t min_threads = 2;
+    size_t max_threads = 4;
+    size_t thread_ceiling = 16;       // Hard limit on max_threads, fixed at startup
+    double target_wait_ms = 20.0;     // Grow while mean queue wait exceeds this
+    double low_utilization = 0.5;     // Shrink only when workers are this idle
+    long interval_ms = 2000;
+};
+PoolTuning g_pool_tuning;
+std::mutex g_pool_tuning_mutex;
+PoolStats g_last_pool_stats{};      // Guarded by g_pool_tuning_mutex
+
+json pool_status_json() {
+    std::lock_guard<std::mutex> lock(g_pool_tuning_mutex);
+    return {
+        {"type", "pool_config"},
+        {"autotune", g_pool_tuning.autotune},
+        {"minThreads", g_pool_tuning.min_threads},
+        {"maxThreads", g_pool_tuning.max_threads},
+        {"targetWaitMs", g_pool_tuning.target_wait_ms},
+        {"lowUtilization", g_pool_tuning.low_utilization},
+        {"threads", g_thread_pool ? g_thread_pool->size() : 0},
+        {"pending", g_thread_pool ? g_thread_pool->pending() : 0},
+        {"avgWaitMs", g_last_pool_stats.avg_wait_ms},
+        {"maxWaitMs", g_last_pool_stats.max_wait_ms},
+        {"utilization", g_last_pool_stats.utilization}
+    };
+}
+
+// Read an optional thread count from a "pool_config" message. Counts must
+// be integers in 1..ceiling; nlohmann would otherwise wrap negatives into
+// huge size_t values. Returns an error message, or "" if the key is valid.
+std::string read_pool_count(const json& j, const char* key, size_t ceiling, size_t& out) {
+    if (!j.contains(key)) return "";
+    const json& value = j[key];
+    if (!value.is_number_integer() || value.get<long long>() < 1 ||
+        value.get<long long>() > static_cast<long long>(ceiling)) {
+        return std::string(key) + " must be an integer between 1 and " + std::to_string(ceiling);
+    }
+    out = static_cast<size_t>(value.get<long long>());
+    return "";
+}
+
+// Apply knobs from a "pool_config" admin message; absent keys are unchanged.
+// The message is validated as a whole: on error nothing changes and the
+// error is returned. An explicit "threads" pins the pool and turns
+// autotune off unless the same message sets "autotune".
+std::string apply_pool_config(const json& j) {
+    size_t resize_to = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_pool_tuning_mutex);
+        PoolTuning t = g_pool_tuning;
+        size_t threads = 0;
+        std::string error = read_pool_count(j, "minThreads", t.thread_ceiling, t.min_threads);
+        if (error.empty()) error = read_pool_count(j, "maxThreads", t.thread_ceiling, t.max_threads);
+        if (error.empty()) error = read_pool_count(j, "threads", t.thread_ceiling, threads);
+        if (error.empty() && j.contains("autotune") && !j["autotune"].is_boolean()) {
+            error = "autotune must be a boolean";
+        }
+        if (error.empty() && j.contains("targetWaitMs") &&
+            (!j["targetWaitMs"].is_number() || j["targetWaitMs"].get<double>() <= 0)) {
+            error = "targetWaitMs must be a positive number";
+        }
+        if (error.empty() && j.contains("lowUtilization") &&
+            (!j["lowUtilization"].is_number() || j["lowUtilization"].get<double>() <= 0 ||
+             j["lowUtilization"].get<double>() > 1)) {
+            error = "lowUtilization must be in (0, 1]";
+        }
+        if (error.empty() && t.min_threads > t.max_threads) {
+            error = "minThreads must not exceed maxThreads";
+        }
+        if (!error.empty()) {
+            getGlobalLogger()->error("", "Pool config rejected: " + error);
+            return error;
+        }
+        
+        t.autotune = j.value("autotune", threads > 0 ? false : t.autotune);
+        t.target_wait_ms = j.value("targetWaitMs", t.target_wait_ms);
+        t.low_utilization = j.value("lowUtilization", t.low_utilization);
+        g_pool_tuning = t;
+        
+        // An explicit size pins the pool (clamped to bounds); otherwise just clamp
+        size_t current = threads > 0 ? threads : g_thread_pool->size();
+        resize_to = std::min(t.max_threads, std::max(t.min_threads, current));
+        getGlobalLogger()->info("", "Pool config updated: min=" + std::to_string(t.min_threads) +
+            " max=" + std::to_string(t.max_threads) + " target_wait_ms=" + std::to_string(t.target_wait_ms) +
+            " autotune=" + std::string(t.autotune ? "on" : "off"));
+    }
+    g_thread_pool->resize(resize_to);
+    return "";
+}
+
+// Grow in proportion to how far mean wait is over the target (at most
+// doubling per tick); shrink one step at a time when waits are short and
+// workers mostly idle. Runs on the timer.
+void tune_thread_pool() {
+    PoolStats stats = g_thread_pool->sample_stats();
+    size_t target = stats.threads;
+    {
+        std::lock_guard<std::mutex> lock(g_pool_tuning_mutex);
+        g_last_pool_stats = stats;
+        const PoolTuning& t = g_pool_tuning;
+        if (t.autotune) {
+            if (stats.avg_wait_ms > t.target_wait_ms) {
+                double over = std::min(1.0, stats.avg_wait_ms / t.target_wait_ms - 1.0);
+                target = stats.threads + std::max<size_t>(1, static_cast<size_t>(std::ceil(stats.threads * over)));
+            } else if (stats.avg_wait_ms < t.target_wait_ms / 4 && stats.utilization < t.low_utilization) {
+                target = stats.threads > 0 ? stats.threads - 1 : 0;
+            }
+        }
+        target = std::min(t.max_threads, std::max(t.min_threads, target));
+    }
+    
+    if (target != stats.threads) {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1) << "Pool resize " << stats.threads << " -> " << target
+           << " (avg_wait_ms=" << stats.avg_wait_ms << " max_wait_ms=" << stats.max_wait_ms
+           << " utilization=" << stats.utilization << " pending=" << stats.pending << ")";
+        getGlobalLogger()->info("", ss.str());
+        g_thread_pool->resize(target);
+    }
+}
+
+// Re-arm the pool tuning timer on the server's io_service
+void schedule_pool_tuning(server* s) {
+    long interval_ms;
+    {
+        std::lock_guard<std::mutex> lock(g_pool_tuning_mutex);
+        interval_ms = g_pool_tuning.interval_ms;
+    }
+    s->set_timer(interval_ms, [s](const websocketpp::lib::error_code& ec) {
+        if (ec) return;
+        try {
+            tune_thread_pool();
+        } catch (const std::exception& e) {
+            getGlobalLogger()->error("", std::string("Pool tuning error: ") + e.what());
+        }
+        schedule_pool_tuning(s);
+    });
+}
+
+// Durable transcript sink (enabled by TRANSCRIPT_SINK_FOLDER)
+std::unique_ptr<TranscriptSink> g_transcript_sink;
+
+// Recognizer features negotiated per session from metadata. Defaults match
+// what every session got before negotiation existed.
+struct RecognizerFeatures {
+    bool partials = true;        // Compute and send partial results
+    bool words = true;           // Word timings in final results
+    int alternatives = 0;        // N-best alternatives in final results (0 = off)
+    bool partial_words = false;  // Word detail in partial results
+    int endpointer_mode = -1;    // Vosk endpointer mode 0-3 (-1 = leave Vosk's default)
+    double endpointer_start_max = 0.0;  // Endpointer timeouts in seconds (0 = Vosk default)
+    double endpointer_end = 0.0;
+    double endpointer_max = 0.0;
+    int final_after_silence_ms = 0;  // Force a final after this much trailing silence (0 = off)
+    
+    json to_json() const {
+        return {
+            {"partials", partials},
+            {"words", words},
+            {"alternatives", alternatives},
+            {"partialWords", partial_words},
+            {"endpointerMode", endpointer_mode},
+            {"endpointerStartMax", endpointer_start_max},
+            {"endpointerEnd", endpointer_end},
+            {"endpointerMax", endpointer_max},
+            {"finalAfterSilenceMs", final_after_silence_ms}
+        };
+    }
+};
+
+// Endpointer controls exist only in newer libvosk builds; resolve them at
+// runtime so the server still links against 0.3.45.
+struct VoskEndpointerApi {
+    void (*set_mode)(VoskRecognizer*, int) = nullptr;
+    void (*set_delays)(VoskRecognizer*, float, float, float) = nullptr;
+};
+
+const VoskEndpointerApi& vosk_endpointer_api() {
+    static const VoskEndpointerApi api = [] {
+        VoskEndpointerApi resolved;
+        resolved.set_mode = reinterpret_cast<void (*)(VoskRecognizer*, int)>(
+            dlsym(RTLD_DEFAULT, "vosk_recognizer_set_endpointer_mode"));
+        resolved.set_delays = reinterpret_cast<void (*)(VoskRecognizer*, float, float, float)>(
+            dlsym(RTLD_DEFAULT, "vosk_recognizer_set_endpointer_delays"));
+        return resolved;
+    }();
+    return api;
+}
+
+// Audio frame waiting for decode
+struct PendingFrame {
+    std::string audio;
+    int64_t due_ms;       // steady clock time the frame's audio ended in real time
+    int64_t deadline_ms;  // due_ms + decode slack
+};
+
 // Connection state - each connection has its own recognizer
 struct ConnectionState {
     std::unique_ptr<VoskRecognizer, decltype(&vosk_recognizer_free)> recognizer;
@@ -226,20 +819,275 @@ struct ConnectionState {
     std::string call_id;          // Voice Tester Call ID from metadata
     std::string fs_uuid;          // FreeSWITCH UUID from metadata
     std::unique_ptr<WavWriter> wav_writer;  // Optional audio recording
+    std::unique_ptr<AudioRingBuffer> audio_ring;  // Last N seconds, written to disk only on trigger
+    std::atomic<int64_t> last_ring_dump_ms;       // steady clock time of last triggered dump
+    std::atomic<int> ring_dump_count;
     std::mutex processing_mutex;  // Ensures sequential processing per connection
     bool is_ready;                // Indicates recognizer is fully initialized
     bool metadata_received;       // Indicates if metadata was received
     std::string last_partial_text;  // For deduplication of partial transcripts
     std::string last_final_text;    // For deduplication of final transcripts
+    RecognizerFeatures features;    // Guarded by processing_mutex
+    int64_t trailing_silence_ms;    // Guarded by processing_mutex; silence since the last loud frame
+    bool heard_speech;              // Guarded by processing_mutex; loud audio since the last final
+    bool words_since_final;         // Guarded by processing_mutex; a non-empty partial since the last final
+    
+    // Transport hooks, set by whichever ingest created the session
+    std::string transport;                                     // "websocket", "unix", ...
+    std::function<void(const std::string&)> send_text;         // Any thread; may throw if the peer is gone
+    std::function<void(const std::string&)> close_transport;   // Any thread
+    std::function<void()> detach_transport;                    // io_service thread; stop routing input here
+    
+    // Stream multiplexing: a gateway connection carries many calls, each a
+    // child session keyed by stream ID (io_service thread only)
+    bool mux_enabled;
+    std::unordered_map<uint32_t, std::shared_ptr<ConnectionState>> mux_streams;
+    
+    // Decode scheduling: frames queue here and one pool task at a time drains
+    // them in order, so sessions never occupy more than one worker
+    std::mutex pending_mutex;
+    std::deque<PendingFrame> pending_frames;
+    bool drain_scheduled;
+    bool closing;                 // Final taken; later frames and drain tasks are dropped
+    int64_t stream_anchor_ms;     // steady clock time matching audio position 0
+    uint64_t audio_samples_queued;
+    std::atomic<bool> background; // Offline/batch stream: scheduled after live calls
+    std::string tenant;           // Tenant key from metadata ("" = default); io_service thread
+    std::atomic<size_t> tenant_slot;  // Decode pool fair-share slot for tenant
+    bool tenant_rejected;         // Metadata named a tenant at its session cap; io_service thread
+    std::atomic<int64_t> decode_lag_ms;      // How far behind real time the last decoded frame finished
+    std::atomic<int64_t> max_decode_lag_ms;
+    
+    // Per-session accounting (read by the idle reaper without processing_mutex)
+    int64_t created_ms;                           // steady clock, set at construction
+    std::atomic<int64_t> last_frame_ms;           // steady clock time of last binary frame
+    std::atomic<uint64_t> bytes_received;         // total audio bytes received
+    std::atomic<uint64_t> bytes_since_final;      // audio decoded since the last final result
+    std::atomic<bool> reaping;                    // set once the reaper has claimed this session
+    std::atomic<bool> holds_recognizer;           // cleared once the recognizer is freed
+    
+    ConnectionState() : recognizer(nullptr, vosk_recognizer_free), last_ring_dump_ms(0), ring_dump_count(0),
+                        is_ready(false), metadata_received(false), trailing_silence_ms(0), heard_speech(false),
+                        words_since_final(false),
+                        mux_enabled(false),
+                        drain_scheduled(false), closing(false), stream_anchor_ms(0), audio_samples_queued(0), background(false), tenant_slot(0), tenant_rejected(false),
+                        decode_lag_ms(0), max_decode_lag_ms(0),
+                        created_ms(steady_now_ms()), last_frame_ms(created_ms), bytes_received(0),
+                        bytes_since_final(0), reaping(false), holds_recognizer(true) {}
+    
+    int64_t idle_ms(int64_t now_ms) const { return now_ms - last_frame_ms.load(); }
+    
+    void send(const std::string& message) {
+        if (send_text) send_text(message);
+    }
+    
+    // Approximate recognizer memory: fixed cost plus growth since last final
+    size_t approx_memory_bytes() const {
+        if (!holds_recognizer) return 0;
+        double seconds = static_cast<double>(bytes_since_final.load()) / (SAMPLE_RATE * 2);
+        return RECOGNIZER_BASE_BYTES + static_cast<size_t>(seconds * RECOGNIZER_BYTES_PER_AUDIO_SEC);
+    }
+    
+    std::string stats_summary() const {
+        int64_t now = steady_now_ms();
+        return "bytes_received=" + std::to_string(bytes_received.load()) +
+               " idle_ms=" + std::to_string(idle_ms(now)) +
+               " age_ms=" + std::to_string(now - created_ms) +
+               " approx_recognizer_bytes=" + std::to_string(approx_memory_bytes()) +
+               " decode_lag_ms=" + std::to_string(decode_lag_ms.load()) +
+               " max_decode_lag_ms=" + std::to_string(max_decode_lag_ms.load());
+    }
+};
+
+// Registry of live sessions on every transport, used for enumeration
+// (reaper, admin lookups, counts). Per-frame lookup goes through the
+// transport's own connection object instead.
+ShardedMap<const ConnectionState*, std::shared_ptr<ConnectionState>> g_sessions;
+
+// Tenant isolation: decode pool weights and concurrent-session caps
+// (TENANT_WEIGHTS, TENANT_MAX_SESSIONS, TENANT_SESSION_CAPS; read-only after startup)
+struct TenantPolicy {
+    std::map<std::string, double> weights;  // Unlisted tenants weigh 1
+    std::map<std::string, long> caps;       // Per-tenant overrides of default_cap
+    long default_cap = 0;                   // 0 = unlimited
     
-    ConnectionState() : recognizer(nullptr, vosk_recognizer_free), is_ready(false), metadata_received(false) {}
+    long cap_for(const std::string& tenant) const {
+        auto it = caps.find(tenant);
+        return it != caps.end() ? it->second : default_cap;
+    }
 };
+TenantPolicy g_tenant_policy;
+std::mutex g_tenant_sessions_mutex;
+std::map<std::string, long> g_tenant_sessions;  // Sessions holding a tenant slot
+
+// Parse "name=value,name=value" into a map
+template <class T>
+std::map<std::string, T> parse_tenant_map(const char* spec) {
+    std::map<std::string, T> result;
+    if (!spec) return result;
+    std::stringstream entries(spec);
+    std::string entry;
+    while (std::getline(entries, entry, ',')) {
+        size_t eq = entry.find('=');
+        if (eq == std::string::npos || eq == 0) continue;
+        std::stringstream value(entry.substr(eq + 1));
+        T parsed{};
+        if (value >> parsed) {
+            result[entry.substr(0, eq)] = parsed;
+        }
+    }
+    return result;
+}
+
+// True if one more session fits under the tenant's cap (checked before
+// allocating a recognizer for it)
+bool tenant_has_capacity(const std::string& tenant) {
+    if (tenant.empty()) return true;
+    long cap = g_tenant_policy.cap_for(tenant);
+    if (cap <= 0) return true;
+    std::lock_guard<std::mutex> lock(g_tenant_sessions_mutex);
+    auto it = g_tenant_sessions.find(tenant);
+    return it == g_tenant_sessions.end() || it->second < cap;
+}
+
+// Move a session to a tenant, enforcing the tenant's session cap.
+// Returns false (leaving the session unchanged) if the tenant is full.
+bool assign_tenant(const std::shared_ptr<ConnectionState>& conn_state, const std::string& tenant) {
+    if (tenant == conn_state->tenant) return true;
+    {
+        std::lock_guard<std::mutex> lock(g_tenant_sessions_mutex);
+        if (!tenant.empty()) {
+            long cap = g_tenant_policy.cap_for(tenant);
+            long& count = g_tenant_sessions[tenant];
+            if (cap > 0 && count >= cap) {
+                return false;
+            }
+            ++count;
+        }
+        if (!conn_state->tenant.empty()) {
+            --g_tenant_sessions[conn_state->tenant];
+        }
+    }
+    conn_state->tenant = tenant;
+    
+    size_t slot = g_thread_pool->tenant_slot(tenant);
+    auto weight = g_tenant_policy.weights.find(tenant);
+    if (weight != g_tenant_policy.weights.end()) {
+        g_thread_pool->set_tenant_weight(slot, weight->second);
+    }
+    conn_state->tenant_slot = slot;
+    return true;
+}
+
+// Session ended: free its place under its tenant's cap
+void release_tenant(ConnectionState* conn_state) {
+    if (conn_state->tenant.empty()) return;
+    std::lock_guard<std::mutex> lock(g_tenant_sessions_mutex);
+    --g_tenant_sessions[conn_state->tenant];
+    conn_state->tenant.clear();
+}
+
+// Per-tenant pool usage plus session counts and decode lag. Sessions that
+// named no tenant are reported under tenant "".
+json tenant_stats_json() {
+    struct Lag {
+        size_t sessions = 0;
+        int64_t total_lag_ms = 0;
+        int64_t max_lag_ms = 0;
+    };
+    std::map<std::string, Lag> lags;
+    g_sessions.forEach([&](const ConnectionState*, const std::shared_ptr<ConnectionState>& session) {
+        Lag& lag = lags[session->tenant];
+        ++lag.sessions;
+        lag.total_lag_ms += session->decode_lag_ms.load();
+        lag.max_lag_ms = std::max(lag.max_lag_ms, session->max_decode_lag_ms.load());
+    });
+    
+    json tenants = json::array();
+    for (const TenantPoolStats& stats : g_thread_pool->tenant_stats()) {
+        const Lag& lag = lags[stats.name];
+        json entry = {
+            {"tenant", stats.name},
+            {"weight", stats.weight},
+            {"sessions", lag.sessions},
+            {"session_cap", stats.name.empty() ? 0 : g_tenant_policy.cap_for(stats.name)},
+            {"cpu_ms", stats.cpu_ms},
+            {"tasks", stats.tasks},
+            {"pending", stats.pending},
+            {"avg_wait_ms", stats.avg_wait_ms},
+            {"max_wait_ms", stats.max_wait_ms},
+            {"avg_decode_lag_ms", lag.sessions ? lag.total_lag_ms / static_cast<int64_t>(lag.sessions) : 0},
+            {"max_decode_lag_ms", lag.max_lag_ms}
+        };
+        tenants.push_back(entry);
+    }
+    return {
+        {"type", "tenant_stats"},
+        {"tenants", tenants}
+    };
+}
+
+// Session attached to a connection, or nullptr once closed or reaped.
+// Lock-free: resolves the handle to its connection and reads its user data.
+std::shared_ptr<ConnectionState> get_session(server* s, connection_hdl hdl) {
+    websocketpp::lib::error_code ec;
+    server::connection_ptr con = s->get_con_from_hdl(hdl, ec);
+    if (ec || !con) {
+        return nullptr;
+    }
+    return con->session;
+}
+
+// Detach a session from its connection (io_service thread only)
+void detach_session(server* s, connection_hdl hdl) {
+    websocketpp::lib::error_code ec;
+    server::connection_ptr con = s->get_con_from_hdl(hdl, ec);
+    if (!ec && con) {
+        con->session.reset();
+    }
+}
 
-std::map<connection_hdl, std::shared_ptr<ConnectionState>, std::owner_less<connection_hdl>> g_connections;
-std::mutex g_connections_mutex;
+// Write the session's rolling audio buffer to disk. Dumps are skipped until
+// the buffer has fully turned over since the previous one, so repeated
+// triggers don't write the same audio twice. Returns true if a dump was queued.
+bool trigger_audio_dump(const std::shared_ptr<ConnectionState>& conn_state, const std::string& reason) {
+    if (!conn_state->audio_ring) return false;
+    
+    int64_t now = steady_now_ms();
+    int64_t last = conn_state->last_ring_dump_ms.load();
+    if (last != 0 && now - last < g_audio_ring_seconds * 1000) {
+        getGlobalLogger()->debug(conn_state->session_uuid, "Audio dump (" + reason + ") skipped, buffer not yet refreshed");
+        return false;
+    }
+    if (!conn_state->last_ring_dump_ms.compare_exchange_strong(last, now)) {
+        return false;
+    }
+    
+    std::string audio = conn_state->audio_ring->snapshot();
+    std::string suffix = reason + "-" + std::to_string(++conn_state->ring_dump_count);
+    std::string session_uuid = conn_state->session_uuid;
+    getGlobalLogger()->info(session_uuid, "Audio dump triggered (" + reason + "), " + std::to_string(audio.size()) + " bytes");
+    
+    // Disk I/O stays off the WebSocket thread and out of the session's processing lock
+    g_thread_pool->enqueue(steady_now_ms(), TaskClass::BACKGROUND, [session_uuid, suffix, audio]() {
+        WavWriter writer(session_uuid, suffix);
+        writer.write_audio(audio.data(), audio.size());
+    });
+    return true;
+}
+
+// True if a final transcript contains one of AUDIO_TRIGGER_KEYWORDS
+bool contains_trigger_keyword(const std::string& text) {
+    for (const auto& keyword : g_audio_trigger_keywords) {
+        if (text.find(keyword) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
 
-// Send transcript back to FreeSWITCH via WebSocket
-void sendTranscriptToFreeSwitch(server* s, connection_hdl hdl, std::shared_ptr<ConnectionState> conn_state, const std::string& text, bool isFinal) {
+// Send transcript back to FreeSWITCH
+void sendTranscriptToFreeSwitch(std::shared_ptr<ConnectionState> conn_state, const std::string& text, bool isFinal) {
     try {
         // Create JSON message with transcript for FreeSWITCH
         json transcriptMsg = {
@@ -252,8 +1100,8 @@ void sendTranscriptToFreeSwitch(server* s, connection_hdl hdl, std::shared_ptr<C
             {"timestamp", get_timestamp()}
         };
         
-        // Send back to FreeSWITCH via WebSocket
-        s->send(hdl, transcriptMsg.dump(), websocketpp::frame::opcode::text);
+        // Send back to FreeSWITCH over the session's transport
+        conn_state->send(transcriptMsg.dump());
         
         getGlobalLogger()->info(conn_state->session_uuid, 
             "Sent transcript back to FreeSWITCH: " + text + (isFinal ? " (FINAL)" : " (PARTIAL)"));
@@ -264,8 +1112,8 @@ void sendTranscriptToFreeSwitch(server* s, connection_hdl hdl, std::shared_ptr<C
     }
 }
 
-// Send ASR session ID back to FreeSWITCH via WebSocket
-void sendAsrSessionIdToFreeSwitch(server* s, connection_hdl hdl, std::shared_ptr<ConnectionState> conn_state) {
+// Send ASR session ID back to FreeSWITCH
+void sendAsrSessionIdToFreeSwitch(std::shared_ptr<ConnectionState> conn_state) {
     try {
         // Create JSON message with ASR session ID for FreeSWITCH
         json asrSessionMsg = {
@@ -273,11 +1121,12 @@ void sendAsrSessionIdToFreeSwitch(server* s, connection_hdl hdl, std::shared_ptr
             {"asr_session_id", conn_state->session_uuid},
             {"call_id", conn_state->call_id},
             {"fs_uuid", conn_state->fs_uuid},
+            {"features", conn_state->features.to_json()},
             {"timestamp", get_timestamp()}
         };
         
-        // Send back to FreeSWITCH via WebSocket
-        s->send(hdl, asrSessionMsg.dump(), websocketpp::frame::opcode::text);
+        // Send back to FreeSWITCH over the session's transport
+        conn_state->send(asrSessionMsg.dump());
         
         getGlobalLogger()->info(conn_state->session_uuid, 
             "Sent ASR session ID back to FreeSWITCH: " + conn_state->session_uuid);
@@ -288,345 +1137,2033 @@ void sendAsrSessionIdToFreeSwitch(server* s, connection_hdl hdl, std::shared_ptr
     }
 }
 
-// WebSocket message handler
-void on_message(server* s, connection_hdl hdl, message_ptr msg) {
+// Push negotiated features into the recognizer.
+// Caller must hold conn_state->processing_mutex.
+void apply_recognizer_features(const std::shared_ptr<ConnectionState>& conn_state) {
+    VoskRecognizer* rec = conn_state->recognizer.get();
+    if (!rec) return;
+    vosk_recognizer_set_max_alternatives(rec, conn_state->features.alternatives);
+    vosk_recognizer_set_words(rec, conn_state->features.words ? 1 : 0);
+    vosk_recognizer_set_partial_words(rec, conn_state->features.partial_words ? 1 : 0);
+    
+    const RecognizerFeatures& f = conn_state->features;
+    const VoskEndpointerApi& endpointer = vosk_endpointer_api();
+    if (endpointer.set_mode && f.endpointer_mode >= 0) {
+        endpointer.set_mode(rec, f.endpointer_mode);
+    }
+    if (endpointer.set_delays && (f.endpointer_start_max > 0 || f.endpointer_end > 0 || f.endpointer_max > 0)) {
+        // Unset values keep Vosk's defaults
+        endpointer.set_delays(rec,
+            static_cast<float>(f.endpointer_start_max > 0 ? f.endpointer_start_max : 5.0),
+            static_cast<float>(f.endpointer_end > 0 ? f.endpointer_end : 0.5),
+            static_cast<float>(f.endpointer_max > 0 ? f.endpointer_max : 20.0));
+    }
+}
+
+// Read feature requests from a metadata message, keeping defaults for absent keys
+RecognizerFeatures parse_recognizer_features(const json& j, const RecognizerFeatures& defaults) {
+    RecognizerFeatures features = defaults;
+    features.partials = j.value("partials", features.partials);
+    features.words = j.value("words", features.words);
+    features.alternatives = std::max(0, std::min(10, j.value("alternatives", features.alternatives)));
+    features.partial_words = j.value("partialWords", features.partial_words);
+    
+    // endpointerMode: "default", "short", "long", "very_long" or 0-3
+    if (j.contains("endpointerMode")) {
+        const json& mode = j["endpointerMode"];
+        if (mode.is_number_integer()) {
+            features.endpointer_mode = std::max(-1, std::min(3, mode.get<int>()));
+        } else if (mode.is_string()) {
+            static const std::map<std::string, int> modes = {
+                {"default", 0}, {"short", 1}, {"long", 2}, {"very_long", 3}
+            };
+            auto it = modes.find(mode.get<std::string>());
+            if (it != modes.end()) features.endpointer_mode = it->second;
+        }
+    }
+    features.endpointer_start_max = std::max(0.0, j.value("endpointerStartMax", features.endpointer_start_max));
+    features.endpointer_end = std::max(0.0, j.value("endpointerEnd", features.endpointer_end));
+    features.endpointer_max = std::max(0.0, j.value("endpointerMax", features.endpointer_max));
+    features.final_after_silence_ms = std::max(0, j.value("finalAfterSilenceMs", features.final_after_silence_ms));
+    return features;
+}
+
+// Server-side endpointing: true once speech has been followed by the
+// session's finalAfterSilenceMs of audio below FINAL_SILENCE_RMS.
+// Caller must hold conn_state->processing_mutex.
+bool forced_final_due(const std::shared_ptr<ConnectionState>& conn_state, const std::string& audio) {
+    int window_ms = conn_state->features.final_after_silence_ms;
+    if (window_ms <= 0) return false;
+    
+    size_t samples = audio.size() / 2;
+    double level = util::rms(reinterpret_cast<const int16_t*>(audio.data()), samples);
+    if (level >= g_final_silence_rms) {
+        conn_state->heard_speech = true;
+        conn_state->trailing_silence_ms = 0;
+        return false;
+    }
+    conn_state->trailing_silence_ms += static_cast<int64_t>(samples) * 1000 / SAMPLE_RATE;
+    if (!conn_state->heard_speech || conn_state->trailing_silence_ms < window_ms) {
+        return false;
+    }
+    conn_state->heard_speech = false;
+    conn_state->trailing_silence_ms = 0;
+    return true;
+}
+
+// Vosk returns {"alternatives":[...]} instead of {"text","result"} when
+// max_alternatives > 0; lift the best alternative to the top level.
+json normalize_result(json result_obj) {
+    if (result_obj.contains("alternatives") && result_obj["alternatives"].is_array() &&
+        !result_obj["alternatives"].empty()) {
+        const json& best = result_obj["alternatives"][0];
+        result_obj["text"] = best.value("text", "");
+        if (best.contains("result")) {
+            result_obj["result"] = best["result"];
+        }
+    }
+    return result_obj;
+}
+
+// Append a final result to the durable transcript sink, if enabled
+void record_final_transcript(const std::shared_ptr<ConnectionState>& conn_state, const json& result_obj, bool on_close) {
+    if (!g_transcript_sink) return;
+    
+    json record = {
+        {"asr_session_id", conn_state->session_uuid},
+        {"call_id", conn_state->call_id},
+        {"fs_uuid", conn_state->fs_uuid},
+        {"text", result_obj.value("text", "")},
+        {"words", result_obj.contains("result") ? result_obj["result"] : json::array()},
+        {"on_close", on_close},
+        {"timestamp", get_timestamp()}
+    };
+    g_transcript_sink->append(record.dump());
+}
+
+// Send a final Vosk result (JSON from vosk_recognizer_result/final_result) to the client.
+// An empty final is a dump trigger only when the recognizer had words in
+// progress: Vosk's endpointer and forced finals also end silent or noisy
+// stretches with an empty final. on_close marks the flush when a session ends,
+// whose final is usually empty because the last utterance was already finalized.
+// Caller must hold conn_state->processing_mutex.
+void emit_final_result(std::shared_ptr<ConnectionState> conn_state, const char* result_json, bool on_close = false) {
+    auto result_obj = normalize_result(json::parse(result_json));
+    bool had_words = conn_state->words_since_final;
+    conn_state->words_since_final = false;
+    
+    if (!result_obj.contains("text") || result_obj["text"].get<std::string>().empty()) {
+        if (!on_close && had_words) {
+            trigger_audio_dump(conn_state, "empty_final");
+        }
+        return;
+    }
+    std::string text = result_obj["text"];
+    
+    if (contains_trigger_keyword(text)) {
+        trigger_audio_dump(conn_state, "keyword");
+    }
+    
+    // Check for duplicate final transcript
+    if (conn_state->last_final_text == text) {
+        getGlobalLogger()->debug(conn_state->session_uuid, 
+            "Duplicate final transcript ignored: \"" + text + "\"");
+        return;
+    }
+    conn_state->last_final_text = text;
+    
+    log_transcript(conn_state->session_uuid, text, "TRANSCRIPT_FINAL", conn_state->call_id);
+    record_final_transcript(conn_state, result_obj, on_close);
+    
+    // Send final transcription to client with session ID
+    json response = {
+        {"type", "transcription"},
+        {"session_uuid", conn_state->session_uuid},
+        {"text", text},
+        {"final", true},
+        {"timestamp", std::chrono::system_clock::now().time_since_epoch().count()}
+    };
+    if (conn_state->features.words && result_obj.contains("result")) {
+        response["words"] = result_obj["result"];
+    }
+    if (conn_state->features.alternatives > 0 && result_obj.contains("alternatives")) {
+        response["alternatives"] = result_obj["alternatives"];
+    }
+    
     try {
-        auto payload = msg->get_payload();
-        auto opcode = msg->get_opcode();
+        conn_state->send(response.dump());
+    } catch (const std::exception& e) {
+        // Connection may have closed, ignore
+    }
+    
+    // Send transcript back to FreeSWITCH for sip_caller
+    sendTranscriptToFreeSwitch(conn_state, text, true);
+}
+
+// Decode one audio frame and send any resulting transcript.
+// Caller must hold conn_state->processing_mutex.
+void process_audio_frame(std::shared_ptr<ConnectionState> conn_state, const std::string& audio_copy) {
+    // Check if recognizer is ready
+    if (!conn_state->is_ready || !conn_state->recognizer) {
+        // Recognizer not ready yet, skip this packet
+        return;
+    }
+    
+    // Receive as-is: should be 16kHz linear PCM int16 from FreeSWITCH
+    const char* audio_data = audio_copy.c_str();
+    int audio_bytes = audio_copy.size();
+    conn_state->bytes_since_final += audio_bytes;
+    
+    // Feed to Vosk (runs on worker thread, not blocking WebSocket I/O)
+    int result = vosk_recognizer_accept_waveform(
+        conn_state->recognizer.get(),
+        audio_data,
+        audio_bytes
+    );
+    
+    // result == 1 means final result is ready
+    // result == 0 means partial result available
+    // result == -1 means the recognizer rejected the audio
+    if (result < 0) {
+        getGlobalLogger()->error(conn_state->session_uuid, "Recognizer failed to accept audio");
+        trigger_audio_dump(conn_state, "error");
+    } else if (result == 1) {
+        // Final result - sentence complete
+        conn_state->bytes_since_final = 0;
+        conn_state->heard_speech = false;
+        conn_state->trailing_silence_ms = 0;
+        const char* result_json = vosk_recognizer_result(conn_state->recognizer.get());
+        emit_final_result(conn_state, result_json);
+    } else if (forced_final_due(conn_state, audio_copy)) {
+        // Trailing silence outlasted the session's window before Vosk's
+        // endpointer fired; flush the utterance now
+        getGlobalLogger()->debug(conn_state->session_uuid, "Forcing final after " +
+            std::to_string(conn_state->features.final_after_silence_ms) + "ms trailing silence");
+        conn_state->bytes_since_final = 0;
+        const char* result_json = vosk_recognizer_final_result(conn_state->recognizer.get());
+        emit_final_result(conn_state, result_json);
+    } else if (conn_state->features.partials) {
+        // Partial result - word in progress (skipped for finals-only sessions)
+        const char* partial_json = vosk_recognizer_partial_result(conn_state->recognizer.get());
+        auto partial_obj = json::parse(partial_json);
         
-        // Check if it's JSON (text) or binary audio data
-        if (opcode == websocketpp::frame::opcode::text) {
-            // Get connection state for session UUID
-            std::shared_ptr<ConnectionState> conn_state;
-            {
-                std::lock_guard<std::mutex> lock(g_connections_mutex);
-                if (g_connections.count(hdl)) {
-                    conn_state = g_connections[hdl];
+        if (partial_obj.contains("partial") && !partial_obj["partial"].get<std::string>().empty()) {
+            conn_state->words_since_final = true;
+            std::string text = partial_obj["partial"];
+            
+            // Check for duplicate partial transcript
+            if (conn_state->last_partial_text != text) {
+                conn_state->last_partial_text = text;
+                
+                //log_transcript(conn_state->session_uuid, text, "TRANSCRIPT_PARTIAL");
+                
+                // Send partial transcription for real-time feedback with session ID
+                json response = {
+                    {"type", "transcription"},
+                    {"session_uuid", conn_state->session_uuid},
+                    {"text", text},
+                    {"final", false},
+                    {"timestamp", std::chrono::system_clock::now().time_since_epoch().count()}
+                };
+                if (conn_state->features.partial_words && partial_obj.contains("partial_result")) {
+                    response["words"] = partial_obj["partial_result"];
+                }
+                
+                try {
+                    conn_state->send(response.dump());
+                } catch (const std::exception& e) {
+                    // Connection may have closed, ignore
+                }
+                
+                // Send partial transcript back to FreeSWITCH for sip_caller
+                sendTranscriptToFreeSwitch(conn_state, text, false);
+            } else {
+                getGlobalLogger()->debug(conn_state->session_uuid, 
+                    "Duplicate partial transcript ignored: \"" + text + "\"");
+            }
+        }
+    } else if (conn_state->audio_ring && !conn_state->words_since_final) {
+        // Finals-only session with a ring buffer: peek at the partial until the
+        // first word so a later empty final can still tell speech from silence
+        auto partial_obj = json::parse(vosk_recognizer_partial_result(conn_state->recognizer.get()));
+        conn_state->words_since_final = !partial_obj.value("partial", "").empty();
+    }
+}
+
+// Pool task: decode the session's oldest pending frame, then reschedule
+// with the next frame's deadline. One frame per task lets a lagging session
+// interleave by deadline with others instead of monopolising a worker.
+void drain_session_audio(std::shared_ptr<ConnectionState> conn_state) {
+    PendingFrame frame;
+    {
+        // Pop under processing_mutex so a closing flush can't slip between
+        // taking this frame and decoding it (lock order: processing, pending)
+        std::lock_guard<std::mutex> processing_lock(conn_state->processing_mutex);
+        {
+            std::lock_guard<std::mutex> lock(conn_state->pending_mutex);
+            if (conn_state->closing || conn_state->pending_frames.empty()) {
+                conn_state->drain_scheduled = false;
+                return;
+            }
+            frame = std::move(conn_state->pending_frames.front());
+            conn_state->pending_frames.pop_front();
+        }
+        
+        try {
+            process_audio_frame(conn_state, frame.audio);
+        } catch (const std::exception& e) {
+            getGlobalLogger()->error(conn_state->session_uuid, std::string("Audio processing error: ") + e.what());
+        }
+    }
+    
+    int64_t lag = std::max<int64_t>(0, steady_now_ms() - frame.due_ms);
+    conn_state->decode_lag_ms = lag;
+    if (lag > conn_state->max_decode_lag_ms) {
+        conn_state->max_decode_lag_ms = lag;
+    }
+    
+    std::lock_guard<std::mutex> lock(conn_state->pending_mutex);
+    if (conn_state->closing || conn_state->pending_frames.empty()) {
+        conn_state->drain_scheduled = false;
+        return;
+    }
+    g_thread_pool->enqueue(conn_state->pending_frames.front().deadline_ms,
+        conn_state->background ? TaskClass::BACKGROUND : TaskClass::LIVE,
+        [conn_state]() { drain_session_audio(conn_state); }, conn_state->tenant_slot.load());
+}
+
+// Queue an audio frame for decode with a deadline from its audio timestamp.
+// The session's real-time clock is anchored at its first frame; a frame is
+// due when its audio would have ended in real time, so a session whose
+// decode has fallen behind carries older deadlines and is served first.
+// Sender gaps (hold, network stalls) re-anchor the clock so they aren't
+// mistaken for decode lag.
+void enqueue_session_audio(std::shared_ptr<ConnectionState> conn_state, std::string audio) {
+    constexpr int64_t SENDER_GAP_MS = 1000;
+    int64_t now = steady_now_ms();
+    
+    std::lock_guard<std::mutex> lock(conn_state->pending_mutex);
+    if (conn_state->closing) {
+        return;
+    }
+    int64_t audio_pos_ms = static_cast<int64_t>(conn_state->audio_samples_queued * 1000 / SAMPLE_RATE);
+    if (conn_state->stream_anchor_ms == 0 || now - (conn_state->stream_anchor_ms + audio_pos_ms) > SENDER_GAP_MS) {
+        conn_state->stream_anchor_ms = now - audio_pos_ms;
+    }
+    conn_state->audio_samples_queued += audio.size() / 2;
+    
+    PendingFrame frame;
+    frame.due_ms = conn_state->stream_anchor_ms +
+        static_cast<int64_t>(conn_state->audio_samples_queued * 1000 / SAMPLE_RATE);
+    frame.deadline_ms = frame.due_ms + g_decode_slack_ms;
+    frame.audio = std::move(audio);
+    int64_t deadline = frame.deadline_ms;
+    conn_state->pending_frames.push_back(std::move(frame));
+    
+    if (!conn_state->drain_scheduled) {
+        conn_state->drain_scheduled = true;
+        g_thread_pool->enqueue(deadline,
+            conn_state->background ? TaskClass::BACKGROUND : TaskClass::LIVE,
+            [conn_state]() { drain_session_audio(conn_state); }, conn_state->tenant_slot.load());
+    }
+}
+
+// Session is ending: decode audio still queued behind decode lag so the
+// closing final covers it, and turn later drain tasks into no-ops.
+// Caller must hold conn_state->processing_mutex.
+void flush_pending_audio(const std::shared_ptr<ConnectionState>& conn_state) {
+    std::deque<PendingFrame> remaining;
+    {
+        std::lock_guard<std::mutex> lock(conn_state->pending_mutex);
+        conn_state->closing = true;
+        remaining.swap(conn_state->pending_frames);
+    }
+    for (const PendingFrame& frame : remaining) {
+        try {
+            process_audio_frame(conn_state, frame.audio);
+        } catch (const std::exception& e) {
+            getGlobalLogger()->error(conn_state->session_uuid, std::string("Audio processing error: ") + e.what());
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// RTP stream bindings
+//
+// A session registered on a control transport (WebSocket or Unix socket)
+// claims RTP streams by SSRC, or by UDP source port for senders whose SSRC
+// isn't known up front. Audio arriving on RTP_PORT is then fed to that
+// session and transcripts go out over its control channel.
+// ---------------------------------------------------------------------------
+
+enum class RtpCodec {
+    PCMU,
+    PCMA,
+    L16
+};
+
+struct RtpBinding {
+    std::weak_ptr<ConnectionState> session;
+    RtpCodec codec = RtpCodec::L16;  // Used for dynamic payload types
+    int rate = SAMPLE_RATE;          // 8000 or 16000
+};
+
+ShardedMap<uint32_t, RtpBinding> g_rtp_ssrc_bindings;
+ShardedMap<uint16_t, RtpBinding> g_rtp_port_bindings;
+
+const char* rtp_codec_name(RtpCodec codec) {
+    switch (codec) {
+        case RtpCodec::PCMU: return "PCMU";
+        case RtpCodec::PCMA: return "PCMA";
+        default: return "L16";
+    }
+}
+
+// Bind RTP streams described by rtpSsrc / rtpSourcePort / rtpCodec / rtpRate.
+// Returns false if the message names no stream.
+// Read an optional integer field of an RTP claim. Values must lie in
+// min_value..max_value; nlohmann would otherwise wrap negative or oversized
+// numbers into a different SSRC or port. Returns an error message, or "".
+std::string read_rtp_field(const json& j, const char* key, long long min_value, long long max_value, long long& out) {
+    if (!j.contains(key)) return "";
+    const json& value = j[key];
+    if (!value.is_number_integer() || value.get<long long>() < min_value || value.get<long long>() > max_value) {
+        return std::string(key) + " must be an integer between " + std::to_string(min_value) +
+               " and " + std::to_string(max_value);
+    }
+    out = value.get<long long>();
+    return "";
+}
+
+bool bind_rtp_stream(const std::shared_ptr<ConnectionState>& conn_state, const json& j) {
+    if (!j.contains("rtpSsrc") && !j.contains("rtpSourcePort")) {
+        return false;
+    }
+    
+    RtpBinding binding;
+    binding.session = conn_state;
+    std::string codec = j.contains("rtpCodec") && j["rtpCodec"].is_string() ? j["rtpCodec"].get<std::string>() : "L16";
+    if (codec == "PCMU") {
+        binding.codec = RtpCodec::PCMU;
+    } else if (codec == "PCMA") {
+        binding.codec = RtpCodec::PCMA;
+    }
+    long long ssrc = -1, source_port = -1, rate = SAMPLE_RATE;
+    std::string error = read_rtp_field(j, "rtpSsrc", 0, UINT32_MAX, ssrc);
+    if (error.empty()) error = read_rtp_field(j, "rtpSourcePort", 1, UINT16_MAX, source_port);
+    if (error.empty() && binding.codec == RtpCodec::L16) error = read_rtp_field(j, "rtpRate", 1, SAMPLE_RATE, rate);
+    binding.rate = binding.codec == RtpCodec::L16 ? static_cast<int>(rate) : 8000;
+    
+    json response = {
+        {"type", "rtp_bound"},
+        {"session_uuid", conn_state->session_uuid},
+        {"port", g_rtp_port},
+        {"codec", rtp_codec_name(binding.codec)},
+        {"rate", binding.rate}
+    };
+    if (g_rtp_port <= 0) {
+        response["type"] = "rtp_error";
+        response["message"] = "RTP ingest disabled (set RTP_PORT)";
+    } else if (!error.empty()) {
+        response["type"] = "rtp_error";
+        response["message"] = error;
+    } else if (binding.rate != 8000 && binding.rate != SAMPLE_RATE) {
+        response["type"] = "rtp_error";
+        response["message"] = "unsupported rtpRate " + std::to_string(binding.rate);
+    } else {
+        // A newer claim on the same stream wins
+        if (ssrc >= 0) {
+            g_rtp_ssrc_bindings.erase(static_cast<uint32_t>(ssrc));
+            g_rtp_ssrc_bindings.insert(static_cast<uint32_t>(ssrc), binding);
+            response["ssrc"] = ssrc;
+        }
+        if (source_port >= 0) {
+            g_rtp_port_bindings.erase(static_cast<uint16_t>(source_port));
+            g_rtp_port_bindings.insert(static_cast<uint16_t>(source_port), binding);
+            response["source_port"] = source_port;
+        }
+        getGlobalLogger()->info(conn_state->session_uuid, "RTP stream bound: " + response.dump());
+    }
+    conn_state->send(response.dump());
+    return true;
+}
+
+// Drop every RTP binding owned by a session
+void unbind_rtp_streams(const ConnectionState* conn_state) {
+    std::vector<uint32_t> ssrcs;
+    std::vector<uint16_t> ports;
+    auto owned = [conn_state](const RtpBinding& binding) {
+        auto session = binding.session.lock();
+        return !session || session.get() == conn_state;
+    };
+    g_rtp_ssrc_bindings.forEach([&](const uint32_t& ssrc, const RtpBinding& binding) {
+        if (owned(binding)) ssrcs.push_back(ssrc);
+    });
+    g_rtp_port_bindings.forEach([&](const uint16_t& port, const RtpBinding& binding) {
+        if (owned(binding)) ports.push_back(port);
+    });
+    for (uint32_t ssrc : ssrcs) g_rtp_ssrc_bindings.erase(ssrc);
+    for (uint16_t port : ports) g_rtp_port_bindings.erase(port);
+}
+
+// Stream multiplexing, defined with the session layer below
+bool handle_mux_message(const std::shared_ptr<ConnectionState>& conn_state, const json& j, const std::string& payload);
+void close_mux_streams(const std::shared_ptr<ConnectionState>& conn_state);
+
+// Admin messages act beyond the sending session (pool sizing, every tenant's
+// usage, other calls' audio), so they must carry ADMIN_TOKEN as "adminToken".
+// Without ADMIN_TOKEN set they are refused on every session.
+bool is_admin_request(const json& j) {
+    auto token = j.find("adminToken");
+    if (g_admin_token.empty() || token == j.end() || !token->is_string()) {
+        return false;
+    }
+    const std::string& given = token->get_ref<const std::string&>();
+    if (given.size() != g_admin_token.size()) {
+        return false;
+    }
+    // Compare every byte so timing doesn't reveal the matching prefix
+    unsigned char diff = 0;
+    for (size_t i = 0; i < given.size(); ++i) {
+        diff |= static_cast<unsigned char>(given[i] ^ g_admin_token[i]);
+    }
+    return diff == 0;
+}
+
+void send_admin_error(const std::shared_ptr<ConnectionState>& conn_state, const std::string& msg_type) {
+    getGlobalLogger()->info(conn_state->session_uuid, "Refused " + msg_type + " without a valid admin token");
+    conn_state->send(json({
+        {"type", "admin_error"},
+        {"session_uuid", conn_state->session_uuid},
+        {"request", msg_type},
+        {"message", g_admin_token.empty() ? "admin messages are disabled" : "invalid admin token"}
+    }).dump());
+}
+
+// Handle a text/control message (metadata or JSON command) for a session,
+// whatever transport it arrived on
+void handle_control_message(std::shared_ptr<ConnectionState> conn_state, const std::string& payload) {
+    // Check if this is metadata from mod_audio_stream (JSON with callId and fsUuid)
+    try {
+        auto j = json::parse(payload);
+        
+        // Stream open/close, or a command addressed to one multiplexed stream
+        if (j.contains("streamId") && handle_mux_message(conn_state, j, payload)) {
+            return;
+        }
+        
+        // Check if this looks like metadata from mod_audio_stream
+        if (j.contains("callId") && j.contains("fsUuid")) {
+            // This is metadata from mod_audio_stream
+            // Tenant first: a session over its tenant's cap goes no further
+            std::string tenant = j.value("tenant", "");
+            if (!assign_tenant(conn_state, tenant)) {
+                getGlobalLogger()->info(conn_state->session_uuid, "Tenant " + tenant + " at session cap, rejecting");
+                {
+                    std::lock_guard<std::mutex> processing_lock(conn_state->processing_mutex);
+                    conn_state->is_ready = false;
+                }
+                conn_state->send(json({
+                    {"type", "tenant_limit"},
+                    {"session_uuid", conn_state->session_uuid},
+                    {"tenant", tenant},
+                    {"message", "tenant session cap reached"}
+                }).dump());
+                // A mux stream is ended by its connection (see handle_mux_message)
+                conn_state->tenant_rejected = true;
+                if (conn_state->transport != "mux" && conn_state->close_transport) {
+                    conn_state->close_transport("tenant session cap reached");
                 }
+                return;
             }
             
-            if (!conn_state) {
-                getGlobalLogger()->error("unknown", "No connection state found for text message");
+            conn_state->call_id = j.value("callId", "");
+            conn_state->fs_uuid = j.value("fsUuid", "");
+            conn_state->metadata_received = true;
+            
+            getGlobalLogger()->info(conn_state->session_uuid, 
+                "Metadata received - CallId: " + conn_state->call_id + 
+                ", FsUuid: " + conn_state->fs_uuid +
+                (conn_state->tenant.empty() ? "" : ", Tenant: " + conn_state->tenant));
+            
+            // Configure the recognizer for the features this client reads
+            {
+                std::lock_guard<std::mutex> processing_lock(conn_state->processing_mutex);
+                conn_state->features = parse_recognizer_features(j, conn_state->features);
+                conn_state->background = j.value("batch", false);
+                apply_recognizer_features(conn_state);
+                getGlobalLogger()->info(conn_state->session_uuid, 
+                    "Recognizer features: " + conn_state->features.to_json().dump());
+            }
+            
+            // Log both IDs for tracking with ASR session ID as primary identifier
+            getGlobalLogger()->info(conn_state->session_uuid, 
+                "CallId: " + conn_state->call_id + 
+                " | FreeSWITCH UUID: " + conn_state->fs_uuid);
+            
+            // Send ASR session ID back to FreeSWITCH
+            sendAsrSessionIdToFreeSwitch(conn_state);
+            
+            // Metadata may also route a forked RTP stream to this session
+            bind_rtp_stream(conn_state, j);
+            
+            return; // Don't process as regular JSON command
+        }
+        
+        // Handle regular JSON commands
+        std::string msg_type = j.value("type", "");
+        
+        if (msg_type == "ping") {
+            json response = {
+                {"type", "pong"},
+                {"timestamp", j.value("timestamp", "")}
+            };
+            response["session_uuid"] = conn_state->session_uuid;
+            conn_state->send(response.dump());
+        } else if (msg_type == "save_audio") {
+            // Dump rolling audio for this session, or (admin) for every session of callId
+            std::string target_call_id = j.value("callId", "");
+            if (!target_call_id.empty() && !is_admin_request(j)) {
+                send_admin_error(conn_state, msg_type);
                 return;
             }
+            std::vector<std::shared_ptr<ConnectionState>> targets;
+            if (target_call_id.empty()) {
+                targets.push_back(conn_state);
+            } else {
+                g_sessions.forEach([&](const ConnectionState*, const std::shared_ptr<ConnectionState>& session) {
+                    if (session->call_id == target_call_id) {
+                        targets.push_back(session);
+                    }
+                });
+            }
             
-            // Check if this is metadata from mod_audio_stream (JSON with callId and fsUuid)
-            try {
-                auto j = json::parse(payload);
+            int dumped = 0;
+            for (const auto& target : targets) {
+                if (trigger_audio_dump(target, "admin")) {
+                    ++dumped;
+                }
+            }
+            json response = {
+                {"type", "save_audio"},
+                {"call_id", target_call_id},
+                {"sessions", targets.size()},
+                {"dumped", dumped}
+            };
+            conn_state->send(response.dump());
+        } else if (msg_type == "pool_config") {
+            // Runtime pool tuning (admin); a message without knobs just reports status
+            if (!is_admin_request(j)) {
+                send_admin_error(conn_state, msg_type);
+                return;
+            }
+            json response = pool_status_json();
+            std::string error = apply_pool_config(j);
+            if (error.empty()) {
+                response = pool_status_json();
+            } else {
+                response["error"] = error;
+            }
+            conn_state->send(response.dump());
+        } else if (msg_type == "rtp_bind") {
+            if (!bind_rtp_stream(conn_state, j)) {
+                conn_state->send(json({
+                    {"type", "rtp_error"},
+                    {"session_uuid", conn_state->session_uuid},
+                    {"message", "rtp_bind needs rtpSsrc or rtpSourcePort"}
+                }).dump());
+            }
+        } else if (msg_type == "tenant_stats") {
+            if (!is_admin_request(j)) {
+                send_admin_error(conn_state, msg_type);
+                return;
+            }
+            conn_state->send(tenant_stats_json().dump());
+        } else if (msg_type == "stats") {
+            int64_t now = steady_now_ms();
+            json response = {
+                {"type", "stats"},
+                {"session_uuid", conn_state->session_uuid},
+                {"bytes_received", conn_state->bytes_received.load()},
+                {"idle_ms", conn_state->idle_ms(now)},
+                {"age_ms", now - conn_state->created_ms},
+                {"approx_recognizer_bytes", conn_state->approx_memory_bytes()},
+                {"decode_lag_ms", conn_state->decode_lag_ms.load()},
+                {"max_decode_lag_ms", conn_state->max_decode_lag_ms.load()},
+                {"process_rss_bytes", get_process_rss_bytes()}
+            };
+            if (conn_state->mux_enabled) {
+                response["mux_streams"] = conn_state->mux_streams.size();
+            }
+            conn_state->send(response.dump());
+        }
+    } catch (const json::parse_error& e) {
+        // Not JSON, might be plain text metadata (fallback)
+        std::string text_payload = payload;
+        if (text_payload.find("callId") != std::string::npos && 
+            text_payload.find("fsUuid") != std::string::npos) {
+            
+            // Try to extract IDs from plain text (basic parsing)
+            size_t callIdPos = text_payload.find("\"callId\":\"");
+            size_t fsUuidPos = text_payload.find("\"fsUuid\":\"");
+            
+            if (callIdPos != std::string::npos && fsUuidPos != std::string::npos) {
+                callIdPos += 10; // Skip "callId":"
+                size_t callIdEnd = text_payload.find("\"", callIdPos);
+                fsUuidPos += 10; // Skip "fsUuid":"
+                size_t fsUuidEnd = text_payload.find("\"", fsUuidPos);
                 
-                // Check if this looks like metadata from mod_audio_stream
-                if (j.contains("callId") && j.contains("fsUuid")) {
-                    // This is metadata from mod_audio_stream
-                    conn_state->call_id = j.value("callId", "");
-                    conn_state->fs_uuid = j.value("fsUuid", "");
+                if (callIdEnd != std::string::npos && fsUuidEnd != std::string::npos) {
+                    conn_state->call_id = text_payload.substr(callIdPos, callIdEnd - callIdPos);
+                    conn_state->fs_uuid = text_payload.substr(fsUuidPos, fsUuidEnd - fsUuidPos);
                     conn_state->metadata_received = true;
                     
                     getGlobalLogger()->info(conn_state->session_uuid, 
-                        "Metadata received - CallId: " + conn_state->call_id + 
+                        "Metadata received (plain text) - CallId: " + conn_state->call_id + 
                         ", FsUuid: " + conn_state->fs_uuid);
                     
-                    // Log both IDs for tracking with ASR session ID as primary identifier
                     getGlobalLogger()->info(conn_state->session_uuid, 
                         "CallId: " + conn_state->call_id + 
                         " | FreeSWITCH UUID: " + conn_state->fs_uuid);
                     
-                    // Send ASR session ID back to FreeSWITCH via WebSocket
-                    sendAsrSessionIdToFreeSwitch(s, hdl, conn_state);
-                    
-                    return; // Don't process as regular JSON command
+                    // Send ASR session ID back to FreeSWITCH
+                    sendAsrSessionIdToFreeSwitch(conn_state);
                 }
-                
-                // Handle regular JSON commands
-                std::string msg_type = j.value("type", "");
-                
-                if (msg_type == "ping") {
-                    json response = {
-                        {"type", "pong"},
-                        {"timestamp", j.value("timestamp", "")}
-                    };
-                    response["session_uuid"] = conn_state->session_uuid;
-                    s->send(hdl, response.dump(), websocketpp::frame::opcode::text);
+            }
+        }
+    }
+}
+
+// Handle one frame of 16kHz linear PCM int16 audio for a session
+void handle_audio_frame(std::shared_ptr<ConnectionState> conn_state, const char* data, size_t size) {
+    // The recognizer itself is only touched under processing_mutex: the RTP
+    // thread feeds sessions too, and the reaper frees the recognizer on a
+    // worker once the session is closing
+    {
+        std::lock_guard<std::mutex> lock(conn_state->pending_mutex);
+        if (conn_state->closing) {
+            return;
+        }
+    }
+    
+    conn_state->bytes_received += size;
+    conn_state->last_frame_ms = steady_now_ms();
+    
+    // Copy audio data (payload is temporary)
+    std::string audio_copy(data, size);
+    
+    // Save audio to WAV file if enabled
+    if (conn_state->wav_writer) {
+        conn_state->wav_writer->write_audio(audio_copy.c_str(), audio_copy.size());
+    }
+    if (conn_state->audio_ring) {
+        conn_state->audio_ring->write(audio_copy.c_str(), audio_copy.size());
+    }
+    
+    // Queue the frame and schedule the session on the decode pool
+    // (keeps transport I/O responsive, see drain_session_audio)
+    enqueue_session_audio(conn_state, std::move(audio_copy));
+}
+
+// Create a session with its own recognizer, ready for audio. The caller
+// sets the transport hooks and then calls register_session().
+std::shared_ptr<ConnectionState> create_session(const std::string& transport) {
+    if (!g_model_ready.load()) {
+        getGlobalLogger()->info("", "Refusing " + transport + " session: model still loading");
+        return nullptr;
+    }
+    
+    auto conn_state = std::make_shared<ConnectionState>();
+    conn_state->transport = transport;
+    
+    // Generate UUID for this ASR session
+    conn_state->session_uuid = generate_uuid();
+    getGlobalLogger()->info(conn_state->session_uuid, "Session created (" + transport + ")");
+    
+    // Create WAV writer if audio saving is enabled
+    if (g_save_audio) {
+        conn_state->wav_writer = std::make_unique<WavWriter>(conn_state->session_uuid);
+    }
+    
+    // Keep the last N seconds in memory for triggered recording
+    if (g_audio_ring_seconds > 0) {
+        conn_state->audio_ring = std::make_unique<AudioRingBuffer>(
+            static_cast<size_t>(g_audio_ring_seconds) * SAMPLE_RATE * 2);
+    }
+    
+    conn_state->features.final_after_silence_ms = static_cast<int>(g_final_silence_ms);
+    
+    // Create a new recognizer for this session
+    {
+        getGlobalLogger()->info(conn_state->session_uuid, "Initializing recognizer");
+        std::lock_guard<std::mutex> model_lock(g_model_mutex);
+        VoskRecognizer* rec = vosk_recognizer_new(g_vosk_model, SAMPLE_RATE);
+        conn_state->recognizer.reset(rec);
+        
+        // Default features until metadata negotiates otherwise
+        apply_recognizer_features(conn_state);
+        getGlobalLogger()->info(conn_state->session_uuid, "Recognizer initialized");
+    }
+    
+    if (!conn_state->recognizer) {
+        getGlobalLogger()->error(conn_state->session_uuid, "Failed to create Vosk recognizer");
+        return nullptr;
+    }
+    
+    // Mark recognizer as ready BEFORE the transport can route audio here
+    // This prevents race where audio arrives before recognizer is initialized
+    {
+        std::lock_guard<std::mutex> ready_lock(conn_state->processing_mutex);
+        conn_state->is_ready = true;
+    }
+    return conn_state;
+}
+
+// Make a session visible to the reaper and admin lookups
+void register_session(const std::shared_ptr<ConnectionState>& conn_state) {
+    g_sessions.insert(conn_state.get(), conn_state);
+    getGlobalLogger()->info(conn_state->session_uuid, "Session connected via " + conn_state->transport +
+        " (total: " + std::to_string(g_sessions.size()) + ")");
+}
+
+// Welcome message with session UUID, sent when a session opens
+json welcome_message(const std::shared_ptr<ConnectionState>& conn_state) {
+    json features = json::array({"partial_results", "real_time", "forced_final"});
+    if (vosk_endpointer_api().set_mode) {
+        features.push_back("endpointer");
+    }
+    return {
+        {"type", "ready"},
+        {"session_uuid", conn_state->session_uuid},
+        {"message", "Vosk ASR ready"},
+        {"sample_rate", SAMPLE_RATE},
+        {"format", "16kHz Linear PCM (L16), mono, int16"},
+        {"features", features}
+    };
+}
+
+// Take the closing final once audio queued behind decode lag is decoded.
+// With send_final the client is still connected (mux_close) and gets the
+// final; otherwise the transport is gone and the transcript sink is the only
+// durable path for the last utterance. Runs on a worker thread.
+void finalize_session(const std::shared_ptr<ConnectionState>& conn_state, bool send_final) {
+    std::lock_guard<std::mutex> processing_lock(conn_state->processing_mutex);
+    flush_pending_audio(conn_state);
+    if (!conn_state->recognizer) {
+        return;
+    }
+    
+    const char* final_json = vosk_recognizer_final_result(conn_state->recognizer.get());
+    if (send_final) {
+        emit_final_result(conn_state, final_json, true);
+        return;
+    }
+    auto final_obj = normalize_result(json::parse(final_json));
+    
+    if (final_obj.contains("text") && !final_obj["text"].get<std::string>().empty()) {
+        std::string text = final_obj["text"];
+        log_transcript(conn_state->session_uuid, text, "TRANSCRIPT_FINAL", conn_state->call_id);
+        record_final_transcript(conn_state, final_obj, true);
+        getGlobalLogger()->info(conn_state->session_uuid, 
+            "Final transcript on close: " + text + " | CallId: " + conn_state->call_id);
+    }
+}
+
+// Transport closed: unregister the session and queue its closing final.
+// The final is taken on the decode pool, since draining a lagging session's
+// backlog here would stall frame ingest for every other session. If
+// on_finalized is set the client is still connected: the final is sent to
+// it and on_finalized runs on the worker afterwards.
+// Returns false if the reaper already claimed the session.
+bool finish_session(std::shared_ptr<ConnectionState> conn_state, std::function<void()> on_finalized = nullptr) {
+    if (!conn_state || !g_sessions.erase(conn_state.get())) {
+        return false;
+    }
+    unbind_rtp_streams(conn_state.get());
+    release_tenant(conn_state.get());
+    close_mux_streams(conn_state);
+    
+    // Log session end with IDs if metadata was received
+    if (conn_state->metadata_received && !conn_state->call_id.empty()) {
+        getGlobalLogger()->info(conn_state->session_uuid, 
+            "CallId: " + conn_state->call_id + 
+            " | FreeSWITCH UUID: " + conn_state->fs_uuid + 
+            " | Session ended");
+    } else {
+        getGlobalLogger()->info(conn_state->session_uuid, conn_state->transport + " closed (total: " + std::to_string(g_sessions.size()) + ")");
+    }
+    getGlobalLogger()->info(conn_state->session_uuid, "Session stats: " + conn_state->stats_summary());
+    
+    // Stop taking frames now; the finalize task decodes whatever is queued
+    {
+        std::lock_guard<std::mutex> lock(conn_state->pending_mutex);
+        conn_state->closing = true;
+    }
+    g_thread_pool->enqueue(steady_now_ms(),
+        conn_state->background ? TaskClass::BACKGROUND : TaskClass::LIVE,
+        [conn_state, on_finalized]() {
+            try {
+                finalize_session(conn_state, static_cast<bool>(on_finalized));
+            } catch (const std::exception& e) {
+                getGlobalLogger()->error(conn_state->session_uuid, std::string("Closing final error: ") + e.what());
+            }
+            if (on_finalized) on_finalized();
+        }, conn_state->tenant_slot.load());
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Multiplexed streams
+//
+// A gateway opts in by sending {"type":"mux_open","streamId":N, ...} on an
+// open session; N is any u32 unique on that connection. The message may
+// carry the usual metadata (callId, fsUuid, features). Each stream gets
+// its own recognizer. After the first mux_open, binary frames on the
+// connection are [u32 LE stream ID][16kHz L16 PCM], and any JSON command
+// with a streamId goes to that stream. Replies and transcripts for a
+// stream carry "stream_id". {"type":"mux_close","streamId":N} flushes the
+// stream's last utterance and ends it. Closing the connection ends every
+// stream.
+// ---------------------------------------------------------------------------
+
+constexpr size_t MUX_HEADER_BYTES = 4;
+
+// Tag a JSON object message with its stream ID without re-parsing it
+std::string tag_stream_message(const std::string& message, uint32_t stream_id) {
+    if (message.size() < 2 || message[0] != '{') {
+        return message;
+    }
+    std::string tagged = "{\"stream_id\":" + std::to_string(stream_id);
+    if (message.size() > 2) {
+        tagged += ',';
+    }
+    tagged.append(message, 1, std::string::npos);
+    return tagged;
+}
+
+void send_mux_closed(const std::shared_ptr<ConnectionState>& parent, uint32_t stream_id, const std::string& reason) {
+    json notice = {
+        {"type", "mux_closed"},
+        {"stream_id", stream_id},
+        {"reason", reason}
+    };
+    try {
+        parent->send(notice.dump());
+    } catch (const std::exception& e) {
+        // Gateway connection may have closed, ignore
+    }
+}
+
+// End one stream: its last utterance goes to the client, followed by mux_closed
+void close_mux_stream(const std::shared_ptr<ConnectionState>& parent, uint32_t stream_id, const std::string& reason) {
+    auto it = parent->mux_streams.find(stream_id);
+    if (it == parent->mux_streams.end()) {
+        send_mux_closed(parent, stream_id, "unknown stream");
+        return;
+    }
+    std::shared_ptr<ConnectionState> child = std::move(it->second);
+    parent->mux_streams.erase(it);
+    
+    auto notify = [parent, stream_id, reason]() { send_mux_closed(parent, stream_id, reason); };
+    if (!finish_session(child, notify)) {
+        notify();
+    }
+}
+
+// Open a child session for a stream on parent's connection
+void open_mux_stream(const std::shared_ptr<ConnectionState>& parent, uint32_t stream_id, const std::string& payload) {
+    if (parent->transport == "mux" || parent->mux_streams.count(stream_id)) {
+        json error = {
+            {"type", "mux_error"},
+            {"stream_id", stream_id},
+            {"message", parent->transport == "mux" ? "streams cannot be nested" : "stream already open"}
+        };
+        parent->send(error.dump());
+        return;
+    }
+    
+    // Refuse over-cap tenants before a recognizer is allocated
+    json j = json::parse(payload);
+    std::string tenant = j.value("tenant", "");
+    if (!tenant_has_capacity(tenant)) {
+        getGlobalLogger()->info(parent->session_uuid, "Tenant " + tenant + " at session cap, refusing mux stream " +
+            std::to_string(stream_id));
+        parent->send(tag_stream_message(json({
+            {"type", "tenant_limit"},
+            {"tenant", tenant},
+            {"message", "tenant session cap reached"}
+        }).dump(), stream_id));
+        send_mux_closed(parent, stream_id, "tenant session cap reached");
+        return;
+    }
+    
+    auto child = create_session("mux");
+    if (!child) {
+        send_mux_closed(parent, stream_id, "session unavailable");
+        return;
+    }
+    
+    std::weak_ptr<ConnectionState> weak_parent = parent;
+    child->send_text = [weak_parent, stream_id](const std::string& message) {
+        if (auto p = weak_parent.lock()) {
+            p->send(tag_stream_message(message, stream_id));
+        }
+    };
+    child->close_transport = [weak_parent, stream_id](const std::string& reason) {
+        if (auto p = weak_parent.lock()) {
+            send_mux_closed(p, stream_id, reason);
+        }
+    };
+    child->detach_transport = [weak_parent, stream_id]() {
+        if (auto p = weak_parent.lock()) {
+            p->mux_streams.erase(stream_id);
+        }
+    };
+    
+    if (!parent->mux_enabled) {
+        // The connection only carries streams from now on; free the parent's
+        // own recognizer rather than keep it resident for the connection
+        std::lock_guard<std::mutex> processing_lock(parent->processing_mutex);
+        parent->recognizer.reset();
+        parent->holds_recognizer = false;
+        parent->mux_enabled = true;
+    }
+    parent->mux_streams.emplace(stream_id, child);
+    register_session(child);
+    getGlobalLogger()->info(child->session_uuid, "Opened mux stream " + std::to_string(stream_id) +
+        " on " + parent->session_uuid + " (streams: " + std::to_string(parent->mux_streams.size()) + ")");
+    child->send(welcome_message(child).dump());
+    
+    // Metadata in the open message configures the stream as if sent on its own
+    if (j.contains("callId") && j.contains("fsUuid")) {
+        j.erase("streamId");
+        handle_control_message(child, j.dump());
+        if (child->tenant_rejected) {
+            close_mux_stream(parent, stream_id, "tenant session cap reached");
+        }
+    }
+}
+
+// Parent's transport closed or was reaped: finish every stream it carried
+void close_mux_streams(const std::shared_ptr<ConnectionState>& conn_state) {
+    auto streams = std::move(conn_state->mux_streams);
+    conn_state->mux_streams.clear();
+    for (auto& entry : streams) {
+        finish_session(entry.second);
+    }
+}
+
+// Returns true if the message was a mux command or was routed to a stream
+bool handle_mux_message(const std::shared_ptr<ConnectionState>& conn_state, const json& j, const std::string& payload) {
+    std::string msg_type = j.value("type", "");
+    uint32_t stream_id = j["streamId"].get<uint32_t>();
+    
+    if (msg_type == "mux_open") {
+        open_mux_stream(conn_state, stream_id, payload);
+        return true;
+    }
+    if (!conn_state->mux_enabled) {
+        return false;  // Not a multiplexed connection; streamId is just a field
+    }
+    if (msg_type == "mux_close") {
+        close_mux_stream(conn_state, stream_id, "closed by client");
+        return true;
+    }
+    
+    auto it = conn_state->mux_streams.find(stream_id);
+    if (it == conn_state->mux_streams.end()) {
+        send_mux_closed(conn_state, stream_id, "unknown stream");
+        return true;
+    }
+    std::shared_ptr<ConnectionState> child = it->second;
+    handle_control_message(child, payload);
+    if (child->tenant_rejected) {
+        close_mux_stream(conn_state, stream_id, "tenant session cap reached");
+    }
+    return true;
+}
+
+// Binary frame on a multiplexed connection: [u32 LE stream ID][PCM]
+void handle_mux_audio_frame(const std::shared_ptr<ConnectionState>& conn_state, const char* data, size_t size) {
+    if (size < MUX_HEADER_BYTES) {
+        getGlobalLogger()->error(conn_state->session_uuid, "Mux audio frame too short: " + std::to_string(size) + " bytes");
+        return;
+    }
+    const uint8_t* header = reinterpret_cast<const uint8_t*>(data);
+    uint32_t stream_id = static_cast<uint32_t>(header[0]) | (static_cast<uint32_t>(header[1]) << 8) |
+                         (static_cast<uint32_t>(header[2]) << 16) | (static_cast<uint32_t>(header[3]) << 24);
+    
+    auto it = conn_state->mux_streams.find(stream_id);
+    if (it == conn_state->mux_streams.end()) {
+        getGlobalLogger()->debug(conn_state->session_uuid, "Audio for unknown mux stream " + std::to_string(stream_id));
+        return;
+    }
+    // The gateway connection itself carries no audio; keep it off the idle reaper
+    conn_state->last_frame_ms = steady_now_ms();
+    handle_audio_frame(it->second, data + MUX_HEADER_BYTES, size - MUX_HEADER_BYTES);
+}
+
+// WebSocket message handler
+void on_message(server* s, connection_hdl hdl, message_ptr msg) {
+    try {
+        const std::string& payload = msg->get_payload();
+        auto opcode = msg->get_opcode();
+        
+        // Get connection state straight from the connection (no global lock per frame)
+        std::shared_ptr<ConnectionState> conn_state = get_session(s, hdl);
+        if (!conn_state) {
+            getGlobalLogger()->error("unknown", "Unknown connection");
+            return;
+        }
+        
+        // Check if it's JSON (text) or binary audio data
+        if (opcode == websocketpp::frame::opcode::text) {
+            handle_control_message(conn_state, payload);
+        }
+        else if (opcode == websocketpp::frame::opcode::binary) {
+            // Handle binary audio data - expect 16kHz linear PCM int16
+            if (conn_state->mux_enabled) {
+                handle_mux_audio_frame(conn_state, payload.data(), payload.size());
+            } else {
+                handle_audio_frame(conn_state, payload.data(), payload.size());
+            }
+        }
+    }
+    catch (const json::exception& e) {
+        getGlobalLogger()->error("", std::string("JSON error: ") + e.what());
+    }
+    catch (const std::exception& e) {
+        getGlobalLogger()->error("", std::string("Message handler error: ") + e.what());
+    }
+}
+
+// Connection opened
+void on_open(server* s, connection_hdl hdl) {
+    // Listening starts before the model is loaded; ask clients to retry
+    if (!g_model_ready.load()) {
+        websocketpp::lib::error_code ec;
+        s->close(hdl, websocketpp::close::status::try_again_later, "Model loading, retry shortly", ec);
+        return;
+    }
+    
+    auto conn_state = create_session("websocket");
+    if (!conn_state) {
+        return;
+    }
+    
+    websocketpp::lib::error_code ec;
+    server::connection_ptr con = s->get_con_from_hdl(hdl, ec);
+    if (ec || !con) {
+        getGlobalLogger()->error(conn_state->session_uuid, "Connection vanished during open");
+        return;
+    }
+    
+    conn_state->send_text = [s, hdl](const std::string& message) {
+        s->send(hdl, message, websocketpp::frame::opcode::text);
+    };
+    conn_state->close_transport = [s, hdl](const std::string& reason) {
+        s->close(hdl, websocketpp::close::status::going_away, reason);
+    };
+    conn_state->detach_transport = [s, hdl]() {
+        detach_session(s, hdl);
+    };
+    
+    // Attach to the connection and register for enumeration
+    con->session = conn_state;
+    register_session(conn_state);
+    
+    getGlobalLogger()->info(conn_state->session_uuid, "Sending welcome message");
+    conn_state->send(welcome_message(conn_state).dump());
+}
+
+// Connection closed
+void on_close(server* s, connection_hdl hdl) {
+    // Detach from the connection first; the reaper may already have claimed it
+    std::shared_ptr<ConnectionState> conn_state = get_session(s, hdl);
+    detach_session(s, hdl);
+    finish_session(conn_state);
+}
+
+// Plain HTTP requests on the WebSocket port: liveness and readiness probes
+//   /healthz  200 while the process is serving I/O
+//   /readyz   200 once the model is loaded, 503 before (or if loading failed)
+void on_http(server* s, connection_hdl hdl) {
+    websocketpp::lib::error_code ec;
+    server::connection_ptr con = s->get_con_from_hdl(hdl, ec);
+    if (ec || !con) {
+        return;
+    }
+    
+    std::string resource = con->get_resource();
+    json body = {
+        {"uptime_ms", steady_now_ms() - g_process_start_ms},
+        {"sessions", g_sessions.size()}
+    };
+    auto status = websocketpp::http::status_code::ok;
+    if (resource == "/healthz") {
+        body["status"] = "alive";
+    } else if (resource == "/readyz") {
+        if (g_model_ready.load()) {
+            body["status"] = "ready";
+        } else {
+            body["status"] = g_model_failed.load() ? "failed" : "loading";
+            status = websocketpp::http::status_code::service_unavailable;
+        }
+    } else {
+        body = {{"status", "not_found"}};
+        status = websocketpp::http::status_code::not_found;
+    }
+    con->set_status(status);
+    con->append_header("Content-Type", "application/json");
+    con->set_body(body.dump());
+}
+
+// Finalize and free an idle session: emit its last result, release the
+// recognizer and close the socket. Runs on a worker thread.
+void reap_session(std::shared_ptr<ConnectionState> conn_state, const std::string& reason) {
+    std::lock_guard<std::mutex> processing_lock(conn_state->processing_mutex);
+    
+    getGlobalLogger()->info(conn_state->session_uuid, "Reaping session (" + reason + "): " + conn_state->stats_summary());
+    unbind_rtp_streams(conn_state.get());
+    release_tenant(conn_state.get());
+    flush_pending_audio(conn_state);
+    
+    if (conn_state->recognizer) {
+        const char* final_json = vosk_recognizer_final_result(conn_state->recognizer.get());
+        emit_final_result(conn_state, final_json, true);
+    }
+    conn_state->is_ready = false;
+    conn_state->recognizer.reset();
+    conn_state->holds_recognizer = false;
+    
+    try {
+        if (conn_state->close_transport) {
+            conn_state->close_transport(reason);
+        }
+    } catch (const std::exception& e) {
+        // Half-open connections may already be gone
+        getGlobalLogger()->debug(conn_state->session_uuid, "Close after reap failed: " + std::string(e.what()));
+    }
+}
+
+// Periodic scan: reap sessions past the idle timeout, then the longest-idle
+// sessions while process RSS is over the memory ceiling.
+void check_idle_sessions() {
+    struct Candidate {
+        std::shared_ptr<ConnectionState> conn_state;
+        int64_t idle_ms;
+    };
+    std::vector<Candidate> candidates;
+    size_t estimated_bytes = 0;
+    size_t session_count = 0;
+    int64_t now = steady_now_ms();
+    
+    session_count = g_sessions.size();
+    g_sessions.forEach([&](const ConnectionState*, const std::shared_ptr<ConnectionState>& session) {
+        estimated_bytes += session->approx_memory_bytes();
+        if (!session->reaping) {
+            candidates.push_back({session, session->idle_ms(now)});
+        }
+    });
+    
+    // Longest idle first
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.idle_ms > b.idle_ms;
+    });
+    
+    size_t rss_bytes = get_process_rss_bytes();
+    size_t ceiling_bytes = static_cast<size_t>(g_memory_ceiling_mb) * 1024 * 1024;
+    bool over_ceiling = ceiling_bytes > 0 && rss_bytes > ceiling_bytes;
+    size_t projected_bytes = rss_bytes;
+    if (over_ceiling) {
+        getGlobalLogger()->info("", "Memory ceiling exceeded: rss=" + std::to_string(rss_bytes) +
+            " ceiling=" + std::to_string(ceiling_bytes) +
+            " sessions=" + std::to_string(session_count) +
+            " estimated_recognizer_bytes=" + std::to_string(estimated_bytes));
+    }
+    
+    for (const auto& candidate : candidates) {
+        std::string reason;
+        if (g_idle_timeout_sec > 0 && candidate.idle_ms >= g_idle_timeout_sec * 1000) {
+            reason = "idle timeout";
+        } else if (over_ceiling && projected_bytes > ceiling_bytes &&
+                   candidate.idle_ms >= g_memory_reap_min_idle_sec * 1000) {
+            reason = "memory ceiling";
+            projected_bytes -= std::min(projected_bytes, candidate.conn_state->approx_memory_bytes());
+        } else {
+            // Sorted by idle time, so nothing further qualifies
+            break;
+        }
+        
+        if (candidate.conn_state->reaping.exchange(true)) {
+            continue;
+        }
+        
+        // Unregister and detach now so on_close and on_message ignore the session
+        if (!g_sessions.erase(candidate.conn_state.get())) {
+            continue;
+        }
+        if (candidate.conn_state->detach_transport) {
+            candidate.conn_state->detach_transport();
+        }
+        close_mux_streams(candidate.conn_state);
+        
+        auto conn_state = candidate.conn_state;
+        g_thread_pool->enqueue([conn_state, reason]() {
+            reap_session(conn_state, reason);
+        });
+    }
+}
+
+// Re-arm the idle check timer on the server's io_service
+void schedule_idle_check(server* s) {
+    s->set_timer(g_reap_interval_sec * 1000, [s](const websocketpp::lib::error_code& ec) {
+        if (ec) return;
+        try {
+            check_idle_sessions();
+        } catch (const std::exception& e) {
+            getGlobalLogger()->error("", std::string("Idle check error: ") + e.what());
+        }
+        schedule_idle_check(s);
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Unix domain socket ingest for co-located FreeSWITCH
+//
+// Same session semantics as the WebSocket path without TCP, HTTP upgrade,
+// masking or the websocketpp parser. Each connection is one session; frames
+// in both directions are [u8 type][u32 payload length, little endian][payload]:
+//   UNIX_FRAME_TEXT   JSON metadata/commands in, JSON replies and transcripts out
+//   UNIX_FRAME_AUDIO  16kHz linear PCM int16 (client -> server)
+// The session ends when the client closes the socket.
+// ---------------------------------------------------------------------------
+
+constexpr uint8_t UNIX_FRAME_TEXT = 1;
+constexpr uint8_t UNIX_FRAME_AUDIO = 2;
+constexpr uint32_t UNIX_FRAME_MAX_BYTES = 1024 * 1024;
+
+class UnixIngestConnection : public std::enable_shared_from_this<UnixIngestConnection> {
+public:
+    explicit UnixIngestConnection(boost::asio::local::stream_protocol::socket socket)
+        : socket_(std::move(socket)), closed_(false) {}
+    
+    void start() {
+        session_ = create_session("unix");
+        if (!session_) {
+            boost::system::error_code ec;
+            socket_.close(ec);
+            return;
+        }
+        
+        std::weak_ptr<UnixIngestConnection> weak_self = shared_from_this();
+        session_->send_text = [weak_self](const std::string& message) {
+            if (auto self = weak_self.lock()) {
+                self->send_frame(UNIX_FRAME_TEXT, message);
+            }
+        };
+        session_->close_transport = [weak_self](const std::string&) {
+            if (auto self = weak_self.lock()) {
+                boost::asio::post(self->socket_.get_executor(), [self]() { self->close(); });
+            }
+        };
+        session_->detach_transport = [weak_self]() {
+            if (auto self = weak_self.lock()) {
+                self->session_.reset();
+            }
+        };
+        
+        register_session(session_);
+        session_->send(welcome_message(session_).dump());
+        read_header();
+    }
+    
+    // Thread-safe: queue a frame and write it from the io_service thread
+    void send_frame(uint8_t type, const std::string& payload) {
+        std::string frame;
+        frame.reserve(payload.size() + 5);
+        frame.push_back(static_cast<char>(type));
+        uint32_t length = static_cast<uint32_t>(payload.size());
+        for (int i = 0; i < 4; ++i) {
+            frame.push_back(static_cast<char>((length >> (8 * i)) & 0xFF));
+        }
+        frame += payload;
+        
+        auto self = shared_from_this();
+        boost::asio::post(socket_.get_executor(), [self, frame = std::move(frame)]() mutable {
+            if (self->closed_) return;
+            self->write_queue_.push_back(std::move(frame));
+            if (self->write_queue_.size() == 1) {
+                self->write_next();
+            }
+        });
+    }
+
+private:
+    void read_header() {
+        auto self = shared_from_this();
+        boost::asio::async_read(socket_, boost::asio::buffer(header_),
+            [self](const boost::system::error_code& ec, size_t) {
+                if (ec) {
+                    self->close();
+                    return;
                 }
-            } catch (const json::parse_error& e) {
-                // Not JSON, might be plain text metadata (fallback)
-                std::string text_payload = payload;
-                if (text_payload.find("callId") != std::string::npos && 
-                    text_payload.find("fsUuid") != std::string::npos) {
-                    
-                    // Try to extract IDs from plain text (basic parsing)
-                    size_t callIdPos = text_payload.find("\"callId\":\"");
-                    size_t fsUuidPos = text_payload.find("\"fsUuid\":\"");
-                    
-                    if (callIdPos != std::string::npos && fsUuidPos != std::string::npos) {
-                        callIdPos += 10; // Skip "callId":"
-                        size_t callIdEnd = text_payload.find("\"", callIdPos);
-                        fsUuidPos += 10; // Skip "fsUuid":"
-                        size_t fsUuidEnd = text_payload.find("\"", fsUuidPos);
-                        
-                        if (callIdEnd != std::string::npos && fsUuidEnd != std::string::npos) {
-                            conn_state->call_id = text_payload.substr(callIdPos, callIdEnd - callIdPos);
-                            conn_state->fs_uuid = text_payload.substr(fsUuidPos, fsUuidEnd - fsUuidPos);
-                            conn_state->metadata_received = true;
-                            
-                            getGlobalLogger()->info(conn_state->session_uuid, 
-                                "Metadata received (plain text) - CallId: " + conn_state->call_id + 
-                                ", FsUuid: " + conn_state->fs_uuid);
-                            
-                            getGlobalLogger()->info(conn_state->session_uuid, 
-                                "CallId: " + conn_state->call_id + 
-                                " | FreeSWITCH UUID: " + conn_state->fs_uuid);
-                            
-                            // Send ASR session ID back to FreeSWITCH via WebSocket
-                            sendAsrSessionIdToFreeSwitch(s, hdl, conn_state);
-                        }
-                    }
+                uint32_t length = static_cast<uint32_t>(self->header_[1]) |
+                                  (static_cast<uint32_t>(self->header_[2]) << 8) |
+                                  (static_cast<uint32_t>(self->header_[3]) << 16) |
+                                  (static_cast<uint32_t>(self->header_[4]) << 24);
+                if (length > UNIX_FRAME_MAX_BYTES) {
+                    getGlobalLogger()->error(self->session_ ? self->session_->session_uuid : "unknown",
+                        "Unix ingest frame too large: " + std::to_string(length) + " bytes");
+                    self->close();
+                    return;
+                }
+                self->payload_.resize(length);
+                self->read_payload();
+            });
+    }
+    
+    void read_payload() {
+        auto self = shared_from_this();
+        boost::asio::async_read(socket_, boost::asio::buffer(&payload_[0], payload_.size()),
+            [self](const boost::system::error_code& ec, size_t) {
+                if (ec) {
+                    self->close();
+                    return;
+                }
+                self->dispatch_frame();
+                self->read_header();
+            });
+    }
+    
+    void dispatch_frame() {
+        // Detached by the reaper: drain input until the close lands
+        if (!session_) return;
+        try {
+            if (header_[0] == UNIX_FRAME_TEXT) {
+                handle_control_message(session_, payload_);
+            } else if (header_[0] == UNIX_FRAME_AUDIO) {
+                if (session_->mux_enabled) {
+                    handle_mux_audio_frame(session_, payload_.data(), payload_.size());
+                } else {
+                    handle_audio_frame(session_, payload_.data(), payload_.size());
+                }
+            } else {
+                getGlobalLogger()->error(session_->session_uuid,
+                    "Unknown unix ingest frame type " + std::to_string(header_[0]));
+            }
+        } catch (const json::exception& e) {
+            getGlobalLogger()->error(session_->session_uuid, std::string("JSON error: ") + e.what());
+        } catch (const std::exception& e) {
+            getGlobalLogger()->error(session_->session_uuid, std::string("Message handler error: ") + e.what());
+        }
+    }
+    
+    void write_next() {
+        auto self = shared_from_this();
+        boost::asio::async_write(socket_, boost::asio::buffer(write_queue_.front()),
+            [self](const boost::system::error_code& ec, size_t) {
+                if (ec) {
+                    self->close();
+                    return;
+                }
+                self->write_queue_.pop_front();
+                if (!self->write_queue_.empty()) {
+                    self->write_next();
                 }
+            });
+    }
+    
+    void close() {
+        if (closed_) return;
+        closed_ = true;
+        boost::system::error_code ec;
+        socket_.close(ec);
+        write_queue_.clear();
+        
+        std::shared_ptr<ConnectionState> session = std::move(session_);
+        finish_session(session);
+    }
+    
+    boost::asio::local::stream_protocol::socket socket_;
+    std::shared_ptr<ConnectionState> session_;  // io_service thread only
+    uint8_t header_[5];
+    std::string payload_;
+    std::deque<std::string> write_queue_;
+    bool closed_;
+};
+
+// Accepts Unix domain socket ingest connections on the server's io_service
+class UnixIngestServer {
+public:
+    UnixIngestServer(boost::asio::io_service& io, const std::string& path)
+        : acceptor_(io), path_(path) {}
+    
+    bool start() {
+        boost::system::error_code ec;
+        ::unlink(path_.c_str());
+        acceptor_.open(boost::asio::local::stream_protocol(), ec);
+        if (!ec) acceptor_.bind(boost::asio::local::stream_protocol::endpoint(path_), ec);
+        if (!ec) acceptor_.listen(boost::asio::socket_base::max_listen_connections, ec);
+        if (ec) {
+            getGlobalLogger()->error("", "Failed to listen on unix socket " + path_ + ": " + ec.message());
+            return false;
+        }
+        accept_next();
+        return true;
+    }
+    
+    ~UnixIngestServer() {
+        boost::system::error_code ec;
+        acceptor_.close(ec);
+        ::unlink(path_.c_str());
+    }
+
+private:
+    void accept_next() {
+        acceptor_.async_accept([this](const boost::system::error_code& ec,
+                                      boost::asio::local::stream_protocol::socket socket) {
+            if (ec == boost::asio::error::operation_aborted) {
+                return;
             }
+            if (!ec) {
+                std::make_shared<UnixIngestConnection>(std::move(socket))->start();
+            }
+            accept_next();
+        });
+    }
+    
+    boost::asio::local::stream_protocol::acceptor acceptor_;
+    std::string path_;
+};
+
+// ---------------------------------------------------------------------------
+// RTP/UDP ingest
+//
+// Media servers that can fork RTP but not run mod_audio_stream send RTP
+// straight to RTP_PORT. Each stream is matched to a session through the
+// bindings above, reordered in a small jitter buffer, decoded to 16kHz
+// L16 and handed to handle_audio_frame. Payload types 0 (PCMU) and 8 (PCMA)
+// are recognized directly; dynamic types use the codec from the binding.
+//
+// A single thread drains the socket with recvmmsg and feeds each stream
+// once per batch, so busy servers pay one syscall and one enqueue per batch
+// rather than per packet.
+// ---------------------------------------------------------------------------
+
+constexpr size_t RTP_RECV_BATCH = 64;
+constexpr size_t RTP_MAX_PACKET = 2048;
+constexpr int64_t RTP_IDLE_FLUSH_MS = 100;  // Release buffered packets once a stream pauses
+
+class RtpIngestServer {
+public:
+    RtpIngestServer(int port, size_t jitter_packets)
+        : port_(port), jitter_packets_(jitter_packets), fd_(-1), stop_(false) {}
+    
+    ~RtpIngestServer() {
+        stop();
+    }
+    
+    bool start() {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) {
+            getGlobalLogger()->error("", std::string("RTP ingest: socket failed: ") + std::strerror(errno));
+            return false;
         }
-        else if (opcode == websocketpp::frame::opcode::binary) {
-            // Handle binary audio data - expect 16kHz linear PCM int16
+        int rcvbuf = 4 * 1024 * 1024;
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        // Wake periodically to flush paused streams and notice stop()
+        timeval timeout{0, static_cast<suseconds_t>(RTP_IDLE_FLUSH_MS * 1000)};
+        ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(port_));
+        if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            getGlobalLogger()->error("", "RTP ingest: bind to port " + std::to_string(port_) + " failed: " +
+                std::strerror(errno));
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        receiver_ = std::thread([this] { receive_loop(); });
+        return true;
+    }
+    
+    void stop() {
+        stop_ = true;
+        if (receiver_.joinable()) {
+            receiver_.join();
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    // Receiver-thread state for one SSRC
+    struct Stream {
+        explicit Stream(const RtpBinding& b, size_t depth) : binding(b), jitter(depth) {}
+        RtpBinding binding;
+        RtpJitterBuffer jitter;
+        int16_t previous_sample = 0;  // Carried across packets for upsampling
+        int64_t last_packet_ms = 0;
+        uint64_t packets = 0;
+        std::vector<std::string> ready;  // Payloads released in this batch
+    };
+    
+    void receive_loop() {
+        std::vector<std::array<char, RTP_MAX_PACKET>> buffers(RTP_RECV_BATCH);
+        std::vector<mmsghdr> messages(RTP_RECV_BATCH);
+        std::vector<iovec> iovecs(RTP_RECV_BATCH);
+        std::vector<sockaddr_in> sources(RTP_RECV_BATCH);
+        
+        while (!stop_) {
+            for (size_t i = 0; i < RTP_RECV_BATCH; ++i) {
+                iovecs[i] = {buffers[i].data(), RTP_MAX_PACKET};
+                messages[i].msg_hdr = {};
+                messages[i].msg_hdr.msg_iov = &iovecs[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+                messages[i].msg_hdr.msg_name = &sources[i];
+                messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            }
             
-            // Get connection state (minimize mutex lock time)
-            std::shared_ptr<ConnectionState> conn_state;
-            {
-                std::lock_guard<std::mutex> lock(g_connections_mutex);
-                
-                if (!g_connections.count(hdl)) {
-                    getGlobalLogger()->error("unknown", "Unknown connection");
-                    return;
-                }
-                
-                conn_state = g_connections[hdl];
-            }  // Release mutex here - don't hold it during Vosk processing!
+            // Blocks for the first datagram, then takes whatever else is queued
+            int received = ::recvmmsg(fd_, messages.data(), RTP_RECV_BATCH, MSG_WAITFORONE, nullptr);
+            int64_t now = steady_now_ms();
+            if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                getGlobalLogger()->error("", std::string("RTP ingest: recvmmsg failed: ") + std::strerror(errno));
+                std::this_thread::sleep_for(std::chrono::milliseconds(RTP_IDLE_FLUSH_MS));
+            }
             
-            if (!conn_state || !conn_state->recognizer) {
-                std::string uuid = conn_state ? conn_state->session_uuid : "unknown";
-                getGlobalLogger()->error(uuid, "Recognizer not initialized");
-                return;
+            for (int i = 0; i < received; ++i) {
+                handle_packet(reinterpret_cast<const uint8_t*>(buffers[i].data()), messages[i].msg_len,
+                              ntohs(sources[i].sin_port), now);
             }
             
-            // Copy audio data (payload is temporary)
-            std::string audio_copy = payload;
+            if (now - last_sweep_ms_ >= RTP_IDLE_FLUSH_MS) {
+                sweep(now);
+                last_sweep_ms_ = now;
+            }
+            deliver();
+        }
+    }
+    
+    void handle_packet(const uint8_t* data, size_t size, uint16_t source_port, int64_t now) {
+        // Fixed header, version 2
+        if (size < 12 || (data[0] >> 6) != 2) return;
+        size_t header = 12 + 4 * static_cast<size_t>(data[0] & 0x0F);
+        if (data[0] & 0x10) {
+            if (size < header + 4) return;
+            header += 4 + 4 * ((static_cast<size_t>(data[header + 2]) << 8) | data[header + 3]);
+        }
+        if (data[0] & 0x20) {
+            size_t padding = data[size - 1];
+            if (padding > size) return;
+            size -= padding;
+        }
+        if (size <= header) return;
+        
+        uint8_t payload_type = data[1] & 0x7F;
+        uint16_t seq = static_cast<uint16_t>((data[2] << 8) | data[3]);
+        uint32_t ssrc = (static_cast<uint32_t>(data[8]) << 24) | (static_cast<uint32_t>(data[9]) << 16) |
+                        (static_cast<uint32_t>(data[10]) << 8) | data[11];
+        
+        Stream* stream = find_stream(ssrc, source_port);
+        if (!stream) return;
+        
+        // Static payload types name their codec; dynamic ones use the binding
+        if (payload_type == 0) {
+            stream->binding.codec = RtpCodec::PCMU;
+            stream->binding.rate = 8000;
+        } else if (payload_type == 8) {
+            stream->binding.codec = RtpCodec::PCMA;
+            stream->binding.rate = 8000;
+        } else if (payload_type < 96) {
+            return;  // Comfort noise, DTMF events on static types, unsupported codecs
+        }
+        
+        ++stream->packets;
+        stream->last_packet_ms = now;
+        stream->jitter.push(seq, std::string(reinterpret_cast<const char*>(data + header), size - header),
+                            stream->ready);
+    }
+    
+    // Stream for an SSRC, resolving (and for source-port bindings, learning)
+    // its session binding on first sight
+    Stream* find_stream(uint32_t ssrc, uint16_t source_port) {
+        auto it = streams_.find(ssrc);
+        if (it != streams_.end()) {
+            return &it->second;
+        }
+        
+        RtpBinding binding;
+        if (!g_rtp_ssrc_bindings.find(ssrc, binding)) {
+            if (!g_rtp_port_bindings.find(source_port, binding)) {
+                return nullptr;
+            }
+            g_rtp_ssrc_bindings.insert(ssrc, binding);
+        }
+        auto session = binding.session.lock();
+        if (!session) return nullptr;
+        
+        getGlobalLogger()->info(session->session_uuid, "RTP stream started: ssrc=" + std::to_string(ssrc) +
+            " source_port=" + std::to_string(source_port));
+        return &streams_.emplace(ssrc, Stream(binding, jitter_packets_)).first->second;
+    }
+    
+    // Flush paused streams and drop ones whose binding or session is gone
+    void sweep(int64_t now) {
+        for (auto it = streams_.begin(); it != streams_.end();) {
+            Stream& stream = it->second;
+            if (!stream.jitter.empty() && now - stream.last_packet_ms >= RTP_IDLE_FLUSH_MS) {
+                stream.jitter.flush(stream.ready);
+            }
             
-            // Save audio to WAV file if enabled
-            if (conn_state->wav_writer) {
-                conn_state->wav_writer->write_audio(audio_copy.c_str(), audio_copy.size());
+            RtpBinding current;
+            auto session = stream.binding.session.lock();
+            bool bound = g_rtp_ssrc_bindings.find(it->first, current) && session &&
+                         current.session.lock() == session;
+            if (bound) {
+                ++it;
+                continue;
             }
+            if (session) {
+                getGlobalLogger()->info(session->session_uuid, "RTP stream ended: ssrc=" + std::to_string(it->first) +
+                    " packets=" + std::to_string(stream.packets) + " lost=" + std::to_string(stream.jitter.lost()) +
+                    " late=" + std::to_string(stream.jitter.late()));
+            }
+            it = streams_.erase(it);
+        }
+    }
+    
+    // Decode each stream's released packets and feed them as one frame
+    void deliver() {
+        std::string pcm;
+        for (auto& entry : streams_) {
+            Stream& stream = entry.second;
+            if (stream.ready.empty()) continue;
             
-            // Offload Vosk processing to thread pool to keep WebSocket I/O responsive!
-            g_thread_pool->enqueue([s, hdl, conn_state, audio_copy]() {
-                // Lock this connection's processing mutex to ensure:
-                // 1. Recognizer is fully initialized before use
-                // 2. Audio packets are processed sequentially (in order)
-                std::lock_guard<std::mutex> processing_lock(conn_state->processing_mutex);
-                
-                // Check if recognizer is ready
-                if (!conn_state->is_ready || !conn_state->recognizer) {
-                    // Recognizer not ready yet, skip this packet
-                    return;
-                }
-                
-                // Receive as-is: should be 16kHz linear PCM int16 from FreeSWITCH
-                const char* audio_data = audio_copy.c_str();
-                int audio_bytes = audio_copy.size();
-                
-                // Feed to Vosk (runs on worker thread, not blocking WebSocket I/O)
-                // The lock ensures packets are processed in order for this connection
-                int result = vosk_recognizer_accept_waveform(
-                    conn_state->recognizer.get(),
-                    audio_data,
-                    audio_bytes
-                );
-                
-                // result == 1 means final result is ready
-                // result == 0 means partial result available
-                if (result == 1) {
-                    // Final result - sentence complete
-                    const char* result_json = vosk_recognizer_result(conn_state->recognizer.get());
-                    auto result_obj = json::parse(result_json);
-                    
-                    if (result_obj.contains("text") && !result_obj["text"].get<std::string>().empty()) {
-                        std::string text = result_obj["text"];
-                        
-                        // Check for duplicate final transcript
-                        if (conn_state->last_final_text != text) {
-                            conn_state->last_final_text = text;
-                            
-                            log_transcript(conn_state->session_uuid, text, "TRANSCRIPT_FINAL", conn_state->call_id);
-                            
-                            // Send final transcription to client with session ID
-                            json response = {
-                                {"type", "transcription"},
-                                {"session_uuid", conn_state->session_uuid},
-                                {"text", text},
-                                {"final", true},
-                                {"timestamp", std::chrono::system_clock::now().time_since_epoch().count()}
-                            };
-                            
-                            try {
-                                s->send(hdl, response.dump(), websocketpp::frame::opcode::text);
-                            } catch (const std::exception& e) {
-                                // Connection may have closed, ignore
-                            }
-                            
-                            // Send transcript back to FreeSWITCH for sip_caller
-                            sendTranscriptToFreeSwitch(s, hdl, conn_state, text, true);
-                        } else {
-                            getGlobalLogger()->debug(conn_state->session_uuid, 
-                                "Duplicate final transcript ignored: \"" + text + "\"");
-                        }
-                    }
-                } else {
-                    // Partial result - word in progress
-                    const char* partial_json = vosk_recognizer_partial_result(conn_state->recognizer.get());
-                    auto partial_obj = json::parse(partial_json);
-                    
-                    if (partial_obj.contains("partial") && !partial_obj["partial"].get<std::string>().empty()) {
-                        std::string text = partial_obj["partial"];
-                        
-                        // Check for duplicate partial transcript
-                        if (conn_state->last_partial_text != text) {
-                            conn_state->last_partial_text = text;
-                            
-                            //log_transcript(conn_state->session_uuid, text, "TRANSCRIPT_PARTIAL");
-                            
-                            // Send partial transcription for real-time feedback with session ID
-                            json response = {
-                                {"type", "transcription"},
-                                {"session_uuid", conn_state->session_uuid},
-                                {"text", text},
-                                {"final", false},
-                                {"timestamp", std::chrono::system_clock::now().time_since_epoch().count()}
-                            };
-                            
-                            try {
-                                s->send(hdl, response.dump(), websocketpp::frame::opcode::text);
-                            } catch (const std::exception& e) {
-                                // Connection may have closed, ignore
-                            }
-                            
-                            // Send partial transcript back to FreeSWITCH for sip_caller
-                            sendTranscriptToFreeSwitch(s, hdl, conn_state, text, false);
-                        } else {
-                            getGlobalLogger()->debug(conn_state->session_uuid, 
-                                "Duplicate partial transcript ignored: \"" + text + "\"");
-                        }
+            auto session = stream.binding.session.lock();
+            if (session && !session->reaping) {
+                pcm.clear();
+                bool upsample = stream.binding.rate == 8000;
+                for (const auto& payload : stream.ready) {
+                    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(payload.data());
+                    switch (stream.binding.codec) {
+                        case RtpCodec::PCMU:
+                            util::decodeUlaw(bytes, payload.size(), upsample, stream.previous_sample, pcm);
+                            break;
+                        case RtpCodec::PCMA:
+                            util::decodeAlaw(bytes, payload.size(), upsample, stream.previous_sample, pcm);
+                            break;
+                        case RtpCodec::L16:
+                            util::decodeL16(bytes, payload.size(), upsample, stream.previous_sample, pcm);
+                            break;
                     }
                 }
-            });
+                try {
+                    handle_audio_frame(session, pcm.data(), pcm.size());
+                } catch (const std::exception& e) {
+                    getGlobalLogger()->error(session->session_uuid, std::string("RTP audio error: ") + e.what());
+                }
+            }
+            stream.ready.clear();
         }
     }
-    catch (const json::exception& e) {
-        getGlobalLogger()->error("", std::string("JSON error: ") + e.what());
+    
+    int port_;
+    size_t jitter_packets_;
+    int fd_;
+    std::atomic<bool> stop_;
+    std::thread receiver_;
+    std::unordered_map<uint32_t, Stream> streams_;  // Receiver thread only
+    int64_t last_sweep_ms_ = 0;
+};
+
+// Load the shared Vosk model from VOSK_MODEL_PATH into g_vosk_model
+bool load_vosk_model() {
+    const char *model_path = std::getenv("VOSK_MODEL_PATH");
+    if (!model_path) {
+        model_path = "/home/rammohanyadavalli/vosk/models/vosk-model-small-en-us-0.15";
     }
-    catch (const std::exception& e) {
-        getGlobalLogger()->error("", std::string("Message handler error: ") + e.what());
+    
+    // Warm the page cache in parallel so vosk_model_new's sequential reads hit memory
+    if (get_env_long("MODEL_PREFETCH", 1) != 0) {
+        int64_t prefetch_start = steady_now_ms();
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        util::PrefetchStats prefetched = util::prefetchTree(model_path, threads);
+        getGlobalLogger()->info("", "Startup: prefetched " + std::to_string(prefetched.files) + " model files (" +
+            std::to_string(prefetched.bytes / (1024 * 1024)) + " MB) in " +
+            std::to_string(steady_now_ms() - prefetch_start) + " ms");
     }
-}
-
-// Connection opened
-void on_open(server* s, connection_hdl hdl) {
-    auto conn_state = std::make_shared<ConnectionState>();
     
-    // Generate UUID for this ASR session
-    conn_state->session_uuid = generate_uuid();
-    getGlobalLogger()->info(conn_state->session_uuid, "Session created");
+    getGlobalLogger()->info("", "Loading Vosk model from: " + std::string(model_path));
     
-    // Create WAV writer if audio saving is enabled
-    if (g_save_audio) {
-        conn_state->wav_writer = std::make_unique<WavWriter>(conn_state->session_uuid);
+    int64_t load_start = steady_now_ms();
+    g_vosk_model = vosk_model_new(model_path);
+    if (!g_vosk_model) {
+        getGlobalLogger()->error("", "Failed to load Vosk model from: " + std::string(model_path));
+        return false;
     }
+    getGlobalLogger()->info("", "Vosk model loaded successfully in " + std::to_string(steady_now_ms() - load_start) + " ms");
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Offline batch transcription
+// ---------------------------------------------------------------------------
+
+// Transcript of one silence-delimited chunk of a batch file
+struct BatchChunkResult {
+    json segments = json::array();  // Finals with word times offset to file time
+    std::string error;
+};
+
+// Decode one chunk with its own recognizer. Word timestamps are shifted by
+// the chunk's start so stitched results are in file time.
+BatchChunkResult transcribe_chunk(const MappedWav& wav, util::AudioSpan span, const RecognizerFeatures& features) {
+    BatchChunkResult chunk_result;
+    const double offset_sec = static_cast<double>(span.begin) / wav.sampleRate();
     
-    // Create a new recognizer for this connection
+    std::unique_ptr<VoskRecognizer, decltype(&vosk_recognizer_free)> recognizer(nullptr, vosk_recognizer_free);
     {
-        getGlobalLogger()->info(conn_state->session_uuid, "Initializing recognizer");
         std::lock_guard<std::mutex> model_lock(g_model_mutex);
-        VoskRecognizer* rec = vosk_recognizer_new(g_vosk_model, SAMPLE_RATE);
-        
-        // Enable word-level results
-        vosk_recognizer_set_max_alternatives(rec, 0);
-        vosk_recognizer_set_words(rec, 1);
+        recognizer.reset(vosk_recognizer_new(g_vosk_model, static_cast<float>(wav.sampleRate())));
+    }
+    if (!recognizer) {
+        chunk_result.error = "failed to create recognizer";
+        return chunk_result;
+    }
+    vosk_recognizer_set_max_alternatives(recognizer.get(), features.alternatives);
+    vosk_recognizer_set_words(recognizer.get(), features.words ? 1 : 0);
+    
+    auto collect = [&](const char* result_json) {
+        json result_obj = normalize_result(json::parse(result_json));
+        std::string text = result_obj.value("text", "");
+        if (text.empty()) return;
         
-        conn_state->recognizer.reset(rec);
-        getGlobalLogger()->info(conn_state->session_uuid, "Recognizer initialized");
+        json segment = {{"text", text}};
+        if (result_obj.contains("result")) {
+            json words = result_obj["result"];
+            for (auto& word : words) {
+                word["start"] = word.value("start", 0.0) + offset_sec;
+                word["end"] = word.value("end", 0.0) + offset_sec;
+            }
+            segment["start"] = words.empty() ? offset_sec : words.front().value("start", offset_sec);
+            segment["end"] = words.empty() ? offset_sec : words.back().value("end", offset_sec);
+            segment["words"] = words;
+        }
+        chunk_result.segments.push_back(segment);
+    };
+    
+    // Feed 200ms at a time, as a live stream would
+    const size_t step = static_cast<size_t>(wav.sampleRate() / 5);
+    for (size_t pos = span.begin; pos < span.end; pos += step) {
+        const int n = static_cast<int>(std::min(step, span.end - pos));
+        int result = vosk_recognizer_accept_waveform_s(recognizer.get(), wav.samples() + pos, n);
+        if (result < 0) {
+            chunk_result.error = "recognizer rejected audio at sample " + std::to_string(pos);
+            return chunk_result;
+        }
+        if (result == 1) {
+            collect(vosk_recognizer_result(recognizer.get()));
+        }
     }
+    collect(vosk_recognizer_final_result(recognizer.get()));
+    return chunk_result;
+}
+
+void print_batch_usage() {
+    std::cerr << "Usage: vosk_asr_ws batch [--list FILE] [--output DIR] [--chunk-sec N] [--threads N] <wav|dir>...\n"
+              << "  Transcribes 16-bit mono PCM WAV files in parallel and prints one JSON line per file\n"
+              << "  (or writes <DIR>/<name>.json with --output).\n";
+}
+
+// Entry point for `vosk_asr_ws batch ...`
+int run_batch(int argc, char* argv[]) {
+    std::vector<std::string> inputs;
+    std::string output_dir;
+    double chunk_sec = static_cast<double>(get_env_long("BATCH_CHUNK_SEC", 30));
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
     
-    if (!conn_state->recognizer) {
-        getGlobalLogger()->error(conn_state->session_uuid, "Failed to create Vosk recognizer");
-        return;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--list" || arg == "--output" || arg == "--chunk-sec" || arg == "--threads") && i + 1 >= argc) {
+            print_batch_usage();
+            return 1;
+        }
+        if (arg == "--list") {
+            std::ifstream list(argv[++i]);
+            std::string line;
+            while (std::getline(list, line)) {
+                if (!line.empty()) inputs.push_back(line);
+            }
+        } else if (arg == "--output") {
+            output_dir = argv[++i];
+        } else if (arg == "--chunk-sec") {
+            char* end = nullptr;
+            chunk_sec = std::strtod(argv[++i], &end);
+            if (end == argv[i] || *end != '\0') chunk_sec = 0;
+        } else if (arg == "--threads") {
+            num_threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "-h" || arg == "--help") {
+            print_batch_usage();
+            return 0;
+        } else {
+            inputs.push_back(arg);
+        }
     }
     
-    // Mark recognizer as ready BEFORE adding to connections map
-    // This prevents race where audio arrives before recognizer is initialized
-    {
-        std::lock_guard<std::mutex> ready_lock(conn_state->processing_mutex);
-        conn_state->is_ready = true;
+    if (!(chunk_sec > 0) || !std::isfinite(chunk_sec)) {
+        print_batch_usage();
+        return 1;
     }
     
-    // Add to connections map
-    {
-        std::lock_guard<std::mutex> lock(g_connections_mutex);
-        g_connections[hdl] = conn_state;
-        getGlobalLogger()->info(conn_state->session_uuid, "WebSocket connected (total: " + std::to_string(g_connections.size()) + ")");
+    // Expand directories to their .wav files, in name order
+    std::vector<std::string> files;
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(input, ec)) {
+            std::vector<std::string> dir_files;
+            for (const auto& entry : std::filesystem::directory_iterator(input, ec)) {
+                std::string ext = entry.path().extension().string();
+                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+                if (entry.is_regular_file() && ext == ".wav") {
+                    dir_files.push_back(entry.path().string());
+                }
+            }
+            std::sort(dir_files.begin(), dir_files.end());
+            files.insert(files.end(), dir_files.begin(), dir_files.end());
+        } else {
+            files.push_back(input);
+        }
+    }
+    if (files.empty()) {
+        print_batch_usage();
+        return 1;
+    }
+    if (!output_dir.empty() && !create_directory(output_dir)) {
+        std::cerr << "[ERR] [system] Failed to create output folder: " << output_dir << "\n";
+        return 1;
     }
     
-    // Send welcome message with session UUID
-    json welcome = {
-        {"type", "ready"},
-        {"session_uuid", conn_state->session_uuid},
-        {"message", "Vosk ASR ready"},
-        {"sample_rate", SAMPLE_RATE},
-        {"format", "16kHz Linear PCM (L16), mono, int16"},
-        {"features", json::array({"partial_results", "real_time"})}
+    if (!load_vosk_model()) {
+        return 1;
+    }
+    
+    auto wall_start = std::chrono::steady_clock::now();
+    RecognizerFeatures features;
+    
+    struct BatchFile {
+        std::unique_ptr<MappedWav> wav;
+        std::vector<std::future<BatchChunkResult>> chunks;
     };
-    getGlobalLogger()->info(conn_state->session_uuid, "Sending welcome message");
-    s->send(hdl, welcome.dump(), websocketpp::frame::opcode::text);
-}
-
-// Connection closed
-void on_close(server* s, connection_hdl hdl) {
-    std::shared_ptr<ConnectionState> conn_state;
+    std::vector<BatchFile> batch(files.size());
+    double total_audio_sec = 0.0;
+    int failed_files = 0;
     
-    // Remove from connections map first
     {
-        std::lock_guard<std::mutex> lock(g_connections_mutex);
+        // Chunks from every file share one pool so short files don't leave cores idle
+        ThreadPool pool(num_threads);
+        getGlobalLogger()->info("", "Batch: " + std::to_string(files.size()) + " files, " +
+            std::to_string(num_threads) + " threads, ~" + std::to_string(static_cast<int>(chunk_sec)) + "s chunks");
         
-        if (g_connections.count(hdl)) {
-            conn_state = g_connections[hdl];
-            g_connections.erase(hdl);
+        for (size_t i = 0; i < files.size(); ++i) {
+            batch[i].wav = std::make_unique<MappedWav>();
+            MappedWav& wav = *batch[i].wav;
+            if (!wav.open(files[i])) {
+                continue;
+            }
+            if (wav.channels() != 1) {
+                continue;
+            }
+            total_audio_sec += wav.durationSec();
             
-            // Log session end with IDs if metadata was received
-            if (conn_state->metadata_received && !conn_state->call_id.empty()) {
-                getGlobalLogger()->info(conn_state->session_uuid, 
-                    "CallId: " + conn_state->call_id + 
-                    " | FreeSWITCH UUID: " + conn_state->fs_uuid + 
-                    " | Session ended");
-            } else {
-                getGlobalLogger()->info(conn_state->session_uuid, "WebSocket closed (total: " + std::to_string(g_connections.size()) + ")");
+            for (const auto& span : util::splitAtSilence(wav.samples(), wav.sampleCount(), wav.sampleRate(), chunk_sec)) {
+                auto promise = std::make_shared<std::promise<BatchChunkResult>>();
+                batch[i].chunks.push_back(promise->get_future());
+                const MappedWav* wav_ptr = &wav;
+                pool.enqueue(steady_now_ms(), TaskClass::BACKGROUND, [promise, wav_ptr, span, features]() {
+                    try {
+                        promise->set_value(transcribe_chunk(*wav_ptr, span, features));
+                    } catch (const std::exception& e) {
+                        BatchChunkResult failed;
+                        failed.error = e.what();
+                        promise->set_value(failed);
+                    }
+                });
             }
         }
-    }
-    
-    // Get final result (lock to ensure no audio processing is happening)
-    if (conn_state && conn_state->recognizer) {
-        std::lock_guard<std::mutex> processing_lock(conn_state->processing_mutex);
         
-        const char* final_json = vosk_recognizer_final_result(conn_state->recognizer.get());
-        auto final_obj = json::parse(final_json);
-        
-        if (final_obj.contains("text") && !final_obj["text"].get<std::string>().empty()) {
-            std::string text = final_obj["text"];
-            log_transcript(conn_state->session_uuid, text, "TRANSCRIPT_FINAL", conn_state->call_id);
+        // Stitch chunks back in order as each file completes
+        for (size_t i = 0; i < files.size(); ++i) {
+            const MappedWav& wav = *batch[i].wav;
+            json file_result = {{"file", files[i]}};
             
-            // Send final transcript back to FreeSWITCH for sip_caller
-            // Note: We can't send via WebSocket here as connection is closed, but we can log it
-            getGlobalLogger()->info(conn_state->session_uuid, 
-                "Final transcript on close: " + text + " | CallId: " + conn_state->call_id);
+            if (!wav.samples()) {
+                file_result["error"] = wav.error();
+            } else if (wav.channels() != 1) {
+                file_result["error"] = "only mono audio is supported (" + std::to_string(wav.channels()) + " channels)";
+            } else {
+                json segments = json::array();
+                json words = json::array();
+                std::string text;
+                for (auto& future : batch[i].chunks) {
+                    BatchChunkResult chunk = future.get();
+                    if (!chunk.error.empty()) {
+                        file_result["error"] = chunk.error;
+                    }
+                    for (const auto& segment : chunk.segments) {
+                        text += (text.empty() ? "" : " ") + segment.value("text", std::string());
+                        if (segment.contains("words")) {
+                            words.insert(words.end(), segment["words"].begin(), segment["words"].end());
+                        }
+                        segments.push_back(segment);
+                    }
+                }
+                file_result["duration_sec"] = wav.durationSec();
+                file_result["chunks"] = batch[i].chunks.size();
+                file_result["text"] = text;
+                file_result["words"] = words;
+                file_result["segments"] = segments;
+            }
+            
+            if (file_result.contains("error")) {
+                ++failed_files;
+                getGlobalLogger()->error("", "Batch: " + files[i] + ": " + file_result["error"].get<std::string>());
+            }
+            
+            if (output_dir.empty()) {
+                std::cout << file_result.dump() << std::endl;
+            } else {
+                std::string out_path = output_dir + "/" + std::filesystem::path(files[i]).stem().string() + ".json";
+                std::ofstream out(out_path);
+                out << file_result.dump(2) << "\n";
+            }
+            batch[i].wav.reset();  // Unmap as soon as the file is done
         }
     }
+    
+    double wall_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    double speed = wall_sec > 0 ? total_audio_sec / wall_sec : 0.0;
+    std::stringstream summary;
+    summary << std::fixed << std::setprecision(2)
+            << "Batch complete: " << files.size() << " files (" << failed_files << " failed), "
+            << total_audio_sec / 3600.0 << " audio-hours in " << wall_sec << "s wall, "
+            << speed << " audio-hours/wall-hour";
+    getGlobalLogger()->info("", summary.str());
+    std::cerr << summary.str() << "\n";
+    
+    vosk_model_free(g_vosk_model);
+    return failed_files == 0 ? 0 : 2;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    g_process_start_ms = steady_now_ms();
+    
     // Set log level - suppress for clean output
     vosk_set_log_level(-1);
     
@@ -636,6 +3173,16 @@ int main() {
         g_log_folder = log_folder_env;
     }
     
+    const char* unix_socket_env = std::getenv("UNIX_SOCKET_PATH");
+    if (unix_socket_env && strlen(unix_socket_env) > 0) {
+        g_unix_socket_path = unix_socket_env;
+    }
+    
+    const char* admin_token_env = std::getenv("ADMIN_TOKEN");
+    if (admin_token_env && strlen(admin_token_env) > 0) {
+        g_admin_token = admin_token_env;
+    }
+    
     const char* recording_folder_env = std::getenv("RECORDING_FOLDER");
     if (recording_folder_env && strlen(recording_folder_env) > 0) {
         g_recording_folder = recording_folder_env;
@@ -647,6 +3194,12 @@ int main() {
         return 1;
     }
     
+    // Offline batch mode: `vosk_asr_ws batch <files...>`
+    if (argc > 1 && std::string(argv[1]) == "batch") {
+        getGlobalLogger()->setLogFile("asr_batch");
+        return run_batch(argc - 2, argv + 2);
+    }
+    
     // Initialize global logger
     getGlobalLogger()->setLogFile("asr");
     
@@ -667,28 +3220,107 @@ int main() {
         getGlobalLogger()->info("", "Audio saving disabled (set SAVE_AUDIO=true to enable)");
     }
     
-    // Load Vosk model
-    const char *model_path = std::getenv("VOSK_MODEL_PATH");
-    if (!model_path) {
-        model_path = "/home/rammohanyadavalli/vosk/models/vosk-model-small-en-us-0.15";
+    // Rolling audio buffer, written to disk only on trigger
+    g_audio_ring_seconds = get_env_long("AUDIO_RING_SECONDS", g_audio_ring_seconds);
+    if (g_audio_ring_seconds > 0) {
+        if (!create_directory(g_recording_folder)) {
+            getGlobalLogger()->error("", "Failed to create recording folder: " + g_recording_folder);
+            return 1;
+        }
+        const char* keywords_env = std::getenv("AUDIO_TRIGGER_KEYWORDS");
+        if (keywords_env) {
+            std::stringstream keywords(keywords_env);
+            std::string keyword;
+            while (std::getline(keywords, keyword, ',')) {
+                if (!keyword.empty()) {
+                    g_audio_trigger_keywords.push_back(keyword);
+                }
+            }
+        }
+        getGlobalLogger()->info("", "Triggered recording ENABLED: last " + std::to_string(g_audio_ring_seconds) +
+            "s per session, " + std::to_string(g_audio_trigger_keywords.size()) + " trigger keywords");
     }
     
-    getGlobalLogger()->info("", "Loading Vosk model from: " + std::string(model_path));
-    
-    g_vosk_model = vosk_model_new(model_path);
-    if (!g_vosk_model) {
-        getGlobalLogger()->error("", "Failed to load Vosk model from: " + std::string(model_path));
-        return 1;
+    // Durable transcript sink
+    const char* sink_folder_env = std::getenv("TRANSCRIPT_SINK_FOLDER");
+    if (sink_folder_env && strlen(sink_folder_env) > 0) {
+        TranscriptSink::Options sink_options;
+        sink_options.folder = sink_folder_env;
+        const char* sink_format_env = std::getenv("TRANSCRIPT_SINK_FORMAT");
+        if (sink_format_env) {
+            sink_options.format = TranscriptSink::parseFormat(sink_format_env);
+        }
+        sink_options.segmentBytes = static_cast<size_t>(get_env_long("TRANSCRIPT_SINK_SEGMENT_MB", 64)) * 1024 * 1024;
+        sink_options.flushIntervalMs = static_cast<int>(get_env_long("TRANSCRIPT_SINK_FLUSH_MS", 50));
+        sink_options.fsync = get_env_long("TRANSCRIPT_SINK_FSYNC", 1) != 0;
+        const char* sink_socket_env = std::getenv("TRANSCRIPT_SINK_SOCKET");
+        if (sink_socket_env) {
+            sink_options.socketPath = sink_socket_env;
+        }
+        
+        if (!create_directory(sink_options.folder)) {
+            getGlobalLogger()->error("", "Failed to create transcript sink folder: " + sink_options.folder);
+            return 1;
+        }
+        g_transcript_sink = std::make_unique<TranscriptSink>(sink_options);
+        if (!g_transcript_sink->start()) {
+            getGlobalLogger()->error("", "Failed to start transcript sink in: " + sink_options.folder);
+            return 1;
+        }
+        getGlobalLogger()->info("", "Transcript sink ENABLED: " + sink_options.folder);
     }
-    getGlobalLogger()->info("", "Vosk model loaded successfully");
     
-    // Initialize thread pool for Vosk processing
+    // Idle session reaping and memory ceiling
+    g_idle_timeout_sec = get_env_long("IDLE_TIMEOUT_SEC", g_idle_timeout_sec);
+    g_memory_ceiling_mb = get_env_long("MEMORY_CEILING_MB", g_memory_ceiling_mb);
+    g_memory_reap_min_idle_sec = get_env_long("MEMORY_REAP_MIN_IDLE_SEC", g_memory_reap_min_idle_sec);
+    getGlobalLogger()->info("", "Idle timeout: " + (g_idle_timeout_sec > 0 ? std::to_string(g_idle_timeout_sec) + "s" : std::string("disabled")) +
+        " | Memory ceiling: " + (g_memory_ceiling_mb > 0 ? std::to_string(g_memory_ceiling_mb) + "MB" : std::string("disabled")));
+    
+    g_decode_slack_ms = get_env_long("DECODE_SLACK_MS", g_decode_slack_ms);
+    g_final_silence_ms = std::max(0L, get_env_long("FINAL_SILENCE_MS", g_final_silence_ms));
+    g_final_silence_rms = get_env_long("FINAL_SILENCE_RMS", g_final_silence_rms);
+    getGlobalLogger()->info("", std::string("Endpointer controls: ") +
+        (vosk_endpointer_api().set_mode ? "available" : "not supported by this libvosk") +
+        " | Forced final after silence: " +
+        (g_final_silence_ms > 0 ? std::to_string(g_final_silence_ms) + "ms" : std::string("per session only")));
+    g_rtp_port = get_env_long("RTP_PORT", g_rtp_port);
+    g_rtp_jitter_packets = get_env_long("RTP_JITTER_PACKETS", g_rtp_jitter_packets);
+    
+    // Initialize thread pool for Vosk processing, sized between POOL_MIN/MAX_THREADS
     size_t num_threads = std::max(4u, std::thread::hardware_concurrency());
+    g_pool_tuning.max_threads = static_cast<size_t>(std::max(1L, get_env_long("POOL_MAX_THREADS", static_cast<long>(num_threads))));
+    // Runtime pool_config can't raise max_threads past POOL_MAX_THREADS, or 4x the default when unset
+    g_pool_tuning.thread_ceiling = std::getenv("POOL_MAX_THREADS") ? g_pool_tuning.max_threads : 4 * num_threads;
+    g_pool_tuning.min_threads = std::min(g_pool_tuning.max_threads,
+        static_cast<size_t>(std::max(1L, get_env_long("POOL_MIN_THREADS", static_cast<long>(g_pool_tuning.min_threads)))));
+    g_pool_tuning.target_wait_ms = static_cast<double>(get_env_long("POOL_TARGET_WAIT_MS", static_cast<long>(g_pool_tuning.target_wait_ms)));
+    g_pool_tuning.interval_ms = std::max(100L, get_env_long("POOL_TUNE_INTERVAL_MS", g_pool_tuning.interval_ms));
+    g_pool_tuning.autotune = get_env_long("POOL_AUTOTUNE", 1) != 0;
+    num_threads = std::min(g_pool_tuning.max_threads, std::max(g_pool_tuning.min_threads, num_threads));
     g_thread_pool = std::make_unique<ThreadPool>(num_threads);
-    getGlobalLogger()->info("", "Thread pool initialized with " + std::to_string(num_threads) + " worker threads");
+    
+    // Tenant fair sharing and session caps
+    g_tenant_policy.weights = parse_tenant_map<double>(std::getenv("TENANT_WEIGHTS"));
+    g_tenant_policy.caps = parse_tenant_map<long>(std::getenv("TENANT_SESSION_CAPS"));
+    g_tenant_policy.default_cap = std::max(0L, get_env_long("TENANT_MAX_SESSIONS", 0));
+    for (const auto& weight : g_tenant_policy.weights) {
+        g_thread_pool->set_tenant_weight(g_thread_pool->tenant_slot(weight.first), weight.second);
+    }
+    if (!g_tenant_policy.weights.empty() || !g_tenant_policy.caps.empty() || g_tenant_policy.default_cap > 0) {
+        getGlobalLogger()->info("", "Tenant policy: " + std::to_string(g_tenant_policy.weights.size()) + " weighted tenants, " +
+            std::to_string(g_tenant_policy.caps.size()) + " session cap overrides, default cap " +
+            (g_tenant_policy.default_cap > 0 ? std::to_string(g_tenant_policy.default_cap) : std::string("unlimited")));
+    }
+    getGlobalLogger()->info("", "Thread pool initialized with " + std::to_string(num_threads) + " worker threads (min " +
+        std::to_string(g_pool_tuning.min_threads) + ", max " + std::to_string(g_pool_tuning.max_threads) +
+        ", autotune " + (g_pool_tuning.autotune ? "on" : "off") + ")");
+    getGlobalLogger()->info("", std::string("Admin messages (pool_config, tenant_stats, save_audio by callId): ") +
+        (g_admin_token.empty() ? "disabled, ADMIN_TOKEN not set" : "require ADMIN_TOKEN"));
     
     // Setup WebSocket server
     server ws_server;
+    std::thread model_loader;
     
     try {
         // Set logging to be less verbose
@@ -717,33 +3349,86 @@ int main() {
         ws_server.set_close_handler([&ws_server](connection_hdl hdl) {
             on_close(&ws_server, hdl);
         });
+        ws_server.set_http_handler([&ws_server](connection_hdl hdl) {
+            on_http(&ws_server, hdl);
+        });
         
-        // Listen on port
+        // Listen before the model is loaded so probes answer and clients get
+        // a retryable close instead of connection refused
         ws_server.listen(PORT);
         ws_server.start_accept();
+        getGlobalLogger()->info("", "Startup: listening on port " + std::to_string(PORT) + " after " +
+            std::to_string(steady_now_ms() - g_process_start_ms) + " ms");
+        
+        // Load the model off the io_service thread; sessions open once it's ready
+        model_loader = std::thread([&ws_server]() {
+            if (load_vosk_model()) {
+                g_model_ready = true;
+                getGlobalLogger()->info("", "Startup: ready to serve after " +
+                    std::to_string(steady_now_ms() - g_process_start_ms) + " ms");
+            } else {
+                g_model_failed = true;
+                boost::asio::post(ws_server.get_io_service(), [&ws_server]() { ws_server.stop(); });
+            }
+        });
+        
+        // Start periodic idle session checks
+        if (g_idle_timeout_sec > 0 || g_memory_ceiling_mb > 0) {
+            schedule_idle_check(&ws_server);
+        }
+        schedule_pool_tuning(&ws_server);
+        
+        // Optional Unix domain socket ingest, served by the same io_service
+        std::unique_ptr<UnixIngestServer> unix_ingest;
+        if (!g_unix_socket_path.empty()) {
+            unix_ingest = std::make_unique<UnixIngestServer>(ws_server.get_io_service(), g_unix_socket_path);
+            if (!unix_ingest->start()) {
+                unix_ingest.reset();
+            } else {
+                getGlobalLogger()->info("", "Unix socket ingest: " + g_unix_socket_path);
+            }
+        }
+        
+        // Optional RTP/UDP ingest on its own receive thread
+        std::unique_ptr<RtpIngestServer> rtp_ingest;
+        if (g_rtp_port > 0) {
+            rtp_ingest = std::make_unique<RtpIngestServer>(static_cast<int>(g_rtp_port),
+                static_cast<size_t>(std::max(1L, g_rtp_jitter_packets)));
+            if (!rtp_ingest->start()) {
+                rtp_ingest.reset();
+                g_rtp_port = 0;
+            } else {
+                getGlobalLogger()->info("", "RTP ingest: udp port " + std::to_string(g_rtp_port) +
+                    " (jitter depth " + std::to_string(g_rtp_jitter_packets) + " packets)");
+            }
+        }
         
         getGlobalLogger()->info("", "Vosk ASR WebSocket Server - MULTI-THREADED MODE");
         getGlobalLogger()->info("", "Port: " + std::to_string(PORT) + " | Format: 16kHz Linear PCM (L16), mono, int16");
         getGlobalLogger()->info("", "Worker Threads: " + std::to_string(num_threads) + " | Audio Recording: " + std::string(g_save_audio ? "ENABLED" : "DISABLED"));
         getGlobalLogger()->info("", "FreeSWITCH Config: uuid_audio_stream <uuid> start ws://172.14.3.108:9000 mixed 16k");
         
-        getGlobalLogger()->info("", "Server ready, waiting for WebSocket connections");
+        getGlobalLogger()->info("", "Server listening, waiting for WebSocket connections");
         
         // Run the server
         ws_server.run();
     }
     catch (const std::exception& e) {
         getGlobalLogger()->error("", std::string("Server error: ") + e.what());
+        if (model_loader.joinable()) model_loader.join();
         g_thread_pool.reset();  // Cleanup thread pool
-        vosk_model_free(g_vosk_model);
+        g_transcript_sink.reset();  // Commit pending transcripts
+        if (g_vosk_model) vosk_model_free(g_vosk_model);
         return 1;
     }
     
     // Cleanup
+    if (model_loader.joinable()) model_loader.join();
     g_thread_pool.reset();  // Shutdown worker threads
-    vosk_model_free(g_vosk_model);
+    g_transcript_sink.reset();  // Commit pending transcripts
+    if (g_vosk_model) vosk_model_free(g_vosk_model);
     
     // Logger will flush/close in its destructor
     
-    return 0;
+    return g_model_failed ? 1 : 0;
 }
@@ -0,0 +1,64 @@
+#include "AudioCodec.h"
+
+namespace util {
+
+namespace {
+
+void appendSample(std::string& out, int16_t sample) {
+    out.append(reinterpret_cast<const char*>(&sample), sizeof(sample));
+}
+
+// Emit one input sample, preceded by its midpoint with the previous sample
+// when upsampling 8kHz -> 16kHz
+void emit(int16_t sample, bool upsample, int16_t& previous, std::string& out) {
+    if (upsample) {
+        appendSample(out, static_cast<int16_t>((static_cast<int32_t>(previous) + sample) / 2));
+    }
+    appendSample(out, sample);
+    previous = sample;
+}
+
+} // namespace
+
+int16_t ulawToLinear(uint8_t value) {
+    value = ~value;
+    int t = ((value & 0x0F) << 3) + 0x84;
+    t <<= (value & 0x70) >> 4;
+    return static_cast<int16_t>((value & 0x80) ? (0x84 - t) : (t - 0x84));
+}
+
+int16_t alawToLinear(uint8_t value) {
+    value ^= 0x55;
+    int t = (value & 0x0F) << 4;
+    int segment = (value & 0x70) >> 4;
+    switch (segment) {
+        case 0: t += 8; break;
+        case 1: t += 0x108; break;
+        default: t += 0x108; t <<= segment - 1; break;
+    }
+    return static_cast<int16_t>((value & 0x80) ? t : -t);
+}
+
+void decodeUlaw(const uint8_t* data, size_t size, bool upsample, int16_t& previous, std::string& out) {
+    out.reserve(out.size() + size * (upsample ? 4 : 2));
+    for (size_t i = 0; i < size; ++i) {
+        emit(ulawToLinear(data[i]), upsample, previous, out);
+    }
+}
+
+void decodeAlaw(const uint8_t* data, size_t size, bool upsample, int16_t& previous, std::string& out) {
+    out.reserve(out.size() + size * (upsample ? 4 : 2));
+    for (size_t i = 0; i < size; ++i) {
+        emit(alawToLinear(data[i]), upsample, previous, out);
+    }
+}
+
+void decodeL16(const uint8_t* data, size_t size, bool upsample, int16_t& previous, std::string& out) {
+    out.reserve(out.size() + size * (upsample ? 2 : 1));
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        // RTP L16 is big endian (RFC 3551)
+        emit(static_cast<int16_t>((data[i] << 8) | data[i + 1]), upsample, previous, out);
+    }
+}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace util {
+
+// G.711 decoding (ITU-T G.711, as used by RTP payload types 0 and 8)
+int16_t ulawToLinear(uint8_t value);
+int16_t alawToLinear(uint8_t value);
+
+// Decode G.711 / network-order L16 payloads to host-order int16 PCM bytes,
+// appending to out. When upsample is set the 8kHz input is doubled to 16kHz
+// by linear interpolation (previous carries the last sample across calls).
+void decodeUlaw(const uint8_t* data, size_t size, bool upsample, int16_t& previous, std::string& out);
+void decodeAlaw(const uint8_t* data, size_t size, bool upsample, int16_t& previous, std::string& out);
+void decodeL16(const uint8_t* data, size_t size, bool upsample, int16_t& previous, std::string& out);
+
+}
@@ -0,0 +1,41 @@
+#include "AudioRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+AudioRingBuffer::AudioRingBuffer(size_t capacityBytes)
+    : buffer_(capacityBytes), head_(0), filled_(0) {}
+
+void AudioRingBuffer::write(const char* data, size_t size) {
+    const size_t capacity = buffer_.size();
+    if (capacity == 0 || size == 0) return;
+
+    // Only the tail of an oversized write can survive
+    if (size > capacity) {
+        data += size - capacity;
+        size = capacity;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t first = std::min(size, capacity - head_);
+    std::memcpy(buffer_.data() + head_, data, first);
+    std::memcpy(buffer_.data(), data + first, size - first);
+    head_ = (head_ + size) % capacity;
+    filled_ = std::min(capacity, filled_ + size);
+}
+
+std::string AudioRingBuffer::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t capacity = buffer_.size();
+    std::string out;
+    out.reserve(filled_);
+    const size_t start = (head_ + capacity - filled_) % (capacity ? capacity : 1);
+    const size_t first = std::min(filled_, capacity - start);
+    out.append(buffer_.data() + start, first);
+    out.append(buffer_.data(), filled_ - first);
+    return out;
+}
+
+size_t AudioRingBuffer::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return filled_;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+// Fixed-size ring holding the most recent audio bytes of a session.
+// Memory is allocated once; writes never grow it, old audio is overwritten.
+class AudioRingBuffer {
+public:
+    explicit AudioRingBuffer(size_t capacityBytes);
+
+    void write(const char* data, size_t size);
+
+    // Buffered audio, oldest first
+    std::string snapshot() const;
+
+    size_t size() const;
+    size_t capacity() const { return buffer_.size(); }
+
+private:
+    std::vector<char> buffer_;
+    size_t head_;    // Next write position
+    size_t filled_;  // Valid bytes (<= capacity)
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,115 @@
+#include "MappedWav.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+uint32_t readLe32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t readLe16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+} // namespace
+
+MappedWav::~MappedWav() {
+    unmap();
+}
+
+void MappedWav::unmap() {
+    if (mapping_) {
+        ::munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+        mappingSize_ = 0;
+    }
+    samples_ = nullptr;
+    sampleCount_ = 0;
+}
+
+bool MappedWav::open(const std::string& path) {
+    unmap();
+    path_ = path;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_ = std::string("cannot open: ") + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < 44) {
+        error_ = "file too small for a WAV header";
+        ::close(fd);
+        return false;
+    }
+    mappingSize_ = static_cast<size_t>(st.st_size);
+    mapping_ = ::mmap(nullptr, mappingSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        error_ = std::string("mmap failed: ") + std::strerror(errno);
+        return false;
+    }
+    // Decoding reads the file front to back
+    ::madvise(mapping_, mappingSize_, MADV_SEQUENTIAL);
+
+    const unsigned char* base = static_cast<const unsigned char*>(mapping_);
+    if (std::memcmp(base, "RIFF", 4) != 0 || std::memcmp(base + 8, "WAVE", 4) != 0) {
+        error_ = "not a RIFF/WAVE file";
+        unmap();
+        return false;
+    }
+
+    // Walk chunks for "fmt " and "data"
+    bool haveFormat = false;
+    size_t offset = 12;
+    while (offset + 8 <= mappingSize_) {
+        const unsigned char* chunk = base + offset;
+        uint32_t chunkSize = readLe32(chunk + 4);
+        const size_t bodyOffset = offset + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && bodyOffset + 16 <= mappingSize_) {
+            uint16_t format = readLe16(base + bodyOffset);
+            channels_ = readLe16(base + bodyOffset + 2);
+            sampleRate_ = static_cast<int>(readLe32(base + bodyOffset + 4));
+            uint16_t bitsPerSample = readLe16(base + bodyOffset + 14);
+            if (format != 1 || bitsPerSample != 16) {
+                error_ = "only 16-bit linear PCM is supported";
+                unmap();
+                return false;
+            }
+            if (channels_ == 0 || sampleRate_ < 8000) {
+                error_ = "invalid format: " + std::to_string(channels_) + " channels at " +
+                         std::to_string(sampleRate_) + " Hz";
+                unmap();
+                return false;
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                error_ = "data chunk before fmt chunk";
+                unmap();
+                return false;
+            }
+            // Recorders that never patched the header leave size 0 or 0xFFFFFFFF
+            size_t dataSize = chunkSize;
+            if (dataSize == 0 || bodyOffset + dataSize > mappingSize_) {
+                dataSize = mappingSize_ - bodyOffset;
+            }
+            samples_ = reinterpret_cast<const int16_t*>(base + bodyOffset);
+            sampleCount_ = dataSize / 2;
+            return true;
+        }
+        offset = bodyOffset + chunkSize + (chunkSize & 1);
+    }
+
+    error_ = "no data chunk";
+    unmap();
+    return false;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only memory mapping of a 16-bit PCM WAV file. Samples are used in
+// place from the mapping, so large recordings are never copied into memory.
+class MappedWav {
+public:
+    MappedWav() = default;
+    ~MappedWav();
+
+    MappedWav(const MappedWav&) = delete;
+    MappedWav& operator=(const MappedWav&) = delete;
+
+    // Maps and validates the file; on failure returns false and sets error()
+    bool open(const std::string& path);
+
+    const int16_t* samples() const { return samples_; }
+    size_t sampleCount() const { return sampleCount_; }
+    int sampleRate() const { return sampleRate_; }
+    int channels() const { return channels_; }
+    double durationSec() const { return sampleRate_ ? static_cast<double>(sampleCount_) / sampleRate_ : 0.0; }
+    const std::string& path() const { return path_; }
+    const std::string& error() const { return error_; }
+
+private:
+    void unmap();
+
+    std::string path_;
+    std::string error_;
+    void* mapping_ = nullptr;
+    size_t mappingSize_ = 0;
+    const int16_t* samples_ = nullptr;
+    size_t sampleCount_ = 0;
+    int sampleRate_ = 0;
+    int channels_ = 0;
+};
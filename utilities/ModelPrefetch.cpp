@@ -0,0 +1,78 @@
+#include "ModelPrefetch.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace util {
+
+namespace {
+
+uint64_t prefetchFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return 0;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+        // Pages stay in the page cache after unmapping
+        ::munmap(mapping, size);
+    } else {
+        ::readahead(fd, 0, size);
+    }
+    ::close(fd);
+    return size;
+}
+
+} // namespace
+
+PrefetchStats prefetchTree(const std::string& root, size_t threads) {
+    PrefetchStats stats;
+    std::vector<std::pair<uint64_t, std::string>> files;
+
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            files.emplace_back(it->file_size(ec), it->path().string());
+        }
+    }
+    if (files.empty()) return stats;
+
+    // Largest first so one big graph file doesn't start last
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> bytes(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            bytes += prefetchFile(files[i].second);
+        }
+    };
+
+    size_t count = std::max<size_t>(1, std::min(threads, files.size()));
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < count; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    stats.files = files.size();
+    stats.bytes = bytes.load();
+    return stats;
+}
+
+}
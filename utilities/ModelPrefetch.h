@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace util {
+
+struct PrefetchStats {
+    size_t files = 0;
+    uint64_t bytes = 0;
+};
+
+// Pull every regular file under root into the page cache, spreading files
+// across up to `threads` workers. Each file is mapped with MAP_POPULATE
+// (falling back to readahead) so a following load reads from memory
+// instead of faulting pages in one by one. Missing paths are ignored.
+PrefetchStats prefetchTree(const std::string& root, size_t threads);
+
+}
@@ -0,0 +1,61 @@
+#include "RtpJitterBuffer.h"
+
+namespace {
+
+// A jump this far from the expected sequence is a sender restart, not jitter
+constexpr int kResyncDistance = 1000;
+
+} // namespace
+
+RtpJitterBuffer::RtpJitterBuffer(size_t depth)
+    : depth_(depth > 0 ? depth : 1), started_(false), next_(0), lost_(0), late_(0) {}
+
+void RtpJitterBuffer::push(uint16_t seq, std::string payload, std::vector<std::string>& ready) {
+    if (!started_) {
+        started_ = true;
+        next_ = seq;
+    }
+
+    // Unwrap relative to the expected sequence number
+    int16_t delta = static_cast<int16_t>(static_cast<uint16_t>(seq - static_cast<uint16_t>(next_)));
+    if (delta > kResyncDistance || delta < -kResyncDistance) {
+        flush(ready);
+        next_ = seq;
+        delta = 0;
+    }
+    int64_t extended = next_ + delta;
+
+    if (extended < next_) {
+        ++late_;
+        return;
+    }
+    if (!packets_.emplace(extended, std::move(payload)).second) {
+        return;  // Duplicate
+    }
+
+    releaseContiguous(ready);
+    while (packets_.size() > depth_) {
+        // Oldest gap waited long enough: give up on the missing packets
+        lost_ += static_cast<uint64_t>(packets_.begin()->first - next_);
+        next_ = packets_.begin()->first;
+        releaseContiguous(ready);
+    }
+}
+
+void RtpJitterBuffer::flush(std::vector<std::string>& ready) {
+    for (auto& entry : packets_) {
+        lost_ += static_cast<uint64_t>(entry.first - next_);
+        ready.push_back(std::move(entry.second));
+        next_ = entry.first + 1;
+    }
+    packets_.clear();
+}
+
+void RtpJitterBuffer::releaseContiguous(std::vector<std::string>& ready) {
+    auto it = packets_.begin();
+    while (it != packets_.end() && it->first == next_) {
+        ready.push_back(std::move(it->second));
+        it = packets_.erase(it);
+        ++next_;
+    }
+}
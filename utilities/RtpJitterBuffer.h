@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+// Minimal RTP reorder buffer for one stream (one SSRC).
+//
+// Packets are held until `depth` packets are buffered or the next expected
+// sequence number arrives, then released in sequence order. Packets older
+// than the release point are dropped as late; gaps that age out of the
+// buffer are skipped and counted as lost. Sequence numbers wrap at 16 bits.
+// Not thread-safe: owned by the receiving thread.
+class RtpJitterBuffer {
+public:
+    explicit RtpJitterBuffer(size_t depth);
+
+    // Insert one packet payload; appends payloads now ready, in order, to ready
+    void push(uint16_t seq, std::string payload, std::vector<std::string>& ready);
+
+    // Release everything still buffered (stream went quiet or ended)
+    void flush(std::vector<std::string>& ready);
+
+    bool empty() const { return packets_.empty(); }
+    uint64_t lost() const { return lost_; }
+    uint64_t late() const { return late_; }
+
+private:
+    void releaseContiguous(std::vector<std::string>& ready);
+
+    size_t depth_;
+    bool started_;
+    int64_t next_;  // Extended (unwrapped) sequence number expected next
+    std::map<int64_t, std::string> packets_;
+    uint64_t lost_;
+    uint64_t late_;
+};
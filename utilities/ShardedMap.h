@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+// Concurrent hash map split into independently locked shards. Inserts and
+// erases lock one shard, so unrelated keys never contend; enumeration walks
+// the shards one at a time and never blocks the whole map.
+template <class Key, class Value, size_t ShardCount = 32, class Hash = std::hash<Key>>
+class ShardedMap {
+public:
+    ShardedMap() : size_(0) {}
+
+    // Returns false if the key was already present (value unchanged)
+    bool insert(const Key& key, const Value& value) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        bool inserted = shard.map.emplace(key, value).second;
+        if (inserted) ++size_;
+        return inserted;
+    }
+
+    // Returns true if this call removed the key; concurrent erasers of the
+    // same key see exactly one success
+    bool erase(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        bool erased = shard.map.erase(key) > 0;
+        if (erased) --size_;
+        return erased;
+    }
+
+    bool find(const Key& key, Value& out) const {
+        const Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    // Visit every entry; fn runs under its shard's lock, so keep it short
+    void forEach(const std::function<void(const Key&, const Value&)>& fn) const {
+        for (const Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (const auto& entry : shard.map) {
+                fn(entry.first, entry.second);
+            }
+        }
+    }
+
+    size_t size() const { return size_.load(); }
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Key, Value, Hash> map;
+    };
+
+    // Pointer and integer hashes are often identity; mix so aligned keys spread
+    static size_t shardIndex(const Key& key) {
+        uint64_t h = static_cast<uint64_t>(Hash{}(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h % ShardCount);
+    }
+
+    Shard& shardFor(const Key& key) { return shards_[shardIndex(key)]; }
+    const Shard& shardFor(const Key& key) const { return shards_[shardIndex(key)]; }
+
+    std::array<Shard, ShardCount> shards_;
+    std::atomic<size_t> size_;
+};
@@ -0,0 +1,77 @@
+#include "SilenceSplitter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace util {
+
+namespace {
+
+constexpr double kFrameSec = 0.01;      // Energy frame
+constexpr size_t kSmoothFrames = 30;    // 300ms window: a pause, not a stop consonant
+
+} // namespace
+
+std::vector<AudioSpan> splitAtSilence(const int16_t* samples, size_t count, int sampleRate, double targetSec) {
+    std::vector<AudioSpan> spans;
+    const size_t frameLen = std::max<size_t>(1, static_cast<size_t>(sampleRate * kFrameSec));
+    const size_t target = static_cast<size_t>(targetSec * sampleRate);
+    if (count == 0) return spans;
+    if (target == 0 || count <= target + target / 4) {
+        spans.push_back({0, count});
+        return spans;
+    }
+
+    // Per-frame energy, then prefix sums for windowed averages
+    const size_t frames = count / frameLen;
+    if (frames <= kSmoothFrames) {
+        spans.push_back({0, count});
+        return spans;
+    }
+    std::vector<double> prefix(frames + 1, 0.0);
+    for (size_t f = 0; f < frames; ++f) {
+        const int16_t* frame = samples + f * frameLen;
+        double energy = 0.0;
+        for (size_t i = 0; i < frameLen; ++i) {
+            energy += static_cast<double>(frame[i]) * frame[i];
+        }
+        prefix[f + 1] = prefix[f] + energy;
+    }
+
+    size_t begin = 0;
+    while (count - begin > target + target / 4) {
+        const size_t lo = (begin + target - target / 4) / frameLen;
+        const size_t hi = std::min(frames - kSmoothFrames, (begin + target + target / 4) / frameLen);
+
+        size_t bestFrame = (begin + target) / frameLen;
+        double bestEnergy = std::numeric_limits<double>::max();
+        for (size_t f = lo; f <= hi && f + kSmoothFrames <= frames; ++f) {
+            double energy = prefix[f + kSmoothFrames] - prefix[f];
+            if (energy < bestEnergy) {
+                bestEnergy = energy;
+                bestFrame = f;
+            }
+        }
+
+        // Cut in the middle of the quiet window
+        size_t cut = (bestFrame + kSmoothFrames / 2) * frameLen;
+        if (cut <= begin || cut >= count) {
+            cut = begin + target;
+        }
+        spans.push_back({begin, cut});
+        begin = cut;
+    }
+    spans.push_back({begin, count});
+    return spans;
+}
+
+double rms(const int16_t* samples, size_t count) {
+    if (count == 0) return 0.0;
+    double energy = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        energy += static_cast<double>(samples[i]) * samples[i];
+    }
+    return std::sqrt(energy / count);
+}
+
+}
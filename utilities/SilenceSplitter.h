@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace util {
+
+struct AudioSpan {
+    size_t begin;  // First sample
+    size_t end;    // One past the last sample
+};
+
+// Split mono PCM into spans of roughly targetSec, cutting at the quietest
+// point within +/-25% of the target so words are not split across chunks.
+std::vector<AudioSpan> splitAtSilence(const int16_t* samples, size_t count, int sampleRate, double targetSec);
+
+// Root-mean-square level of a block of samples (0 for an empty block)
+double rms(const int16_t* samples, size_t count);
+
+}
@@ -0,0 +1,295 @@
+#include "TranscriptSink.h"
+#include "GlobalLogger.h"
+#include <chrono>
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+namespace {
+
+constexpr uint32_t kBinaryMagic = 0x52535341;  // "ASSR" little endian
+constexpr int kRetryIntervalMs = 1000;         // Wait between commit attempts after a failure
+
+uint32_t crc32(const std::string& data) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (unsigned char c : data) {
+        crc ^= c;
+        for (int k = 0; k < 8; ++k) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+void putLe32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+TranscriptSink::TranscriptSink(const Options& options)
+    : options_(options), stop_(false), segmentFd_(-1), segmentSize_(0), segmentSeq_(0),
+      listenFd_(-1), committedRecords_(0) {}
+
+TranscriptSink::~TranscriptSink() {
+    stop();
+}
+
+TranscriptSink::Format TranscriptSink::parseFormat(const std::string& formatStr) {
+    std::string lower = formatStr;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower == "binary" ? Format::BINARY : Format::JSONL;
+}
+
+bool TranscriptSink::start() {
+    if (!openSegment()) {
+        return false;
+    }
+
+    if (!options_.socketPath.empty()) {
+        listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (listenFd_ < 0 || options_.socketPath.size() >= sizeof(addr.sun_path)) {
+            getGlobalLogger()->error("", "Transcript sink: invalid subscriber socket " + options_.socketPath);
+            if (listenFd_ >= 0) { ::close(listenFd_); listenFd_ = -1; }
+        } else {
+            std::strncpy(addr.sun_path, options_.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+            ::unlink(options_.socketPath.c_str());
+            if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+                ::listen(listenFd_, 16) != 0) {
+                getGlobalLogger()->error("", "Transcript sink: failed to listen on " + options_.socketPath +
+                    ": " + std::strerror(errno));
+                ::close(listenFd_);
+                listenFd_ = -1;
+            } else {
+                acceptor_ = std::thread([this] { acceptLoop(); });
+                getGlobalLogger()->info("", "Transcript sink subscribers: " + options_.socketPath);
+            }
+        }
+    }
+
+    writer_ = std::thread([this] { writerLoop(); });
+    return true;
+}
+
+void TranscriptSink::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stop_) return;
+        stop_ = true;
+    }
+    queueCondition_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    if (listenFd_ >= 0) {
+        // Wakes the blocking accept()
+        ::shutdown(listenFd_, SHUT_RDWR);
+        if (acceptor_.joinable()) {
+            acceptor_.join();
+        }
+        ::close(listenFd_);
+        listenFd_ = -1;
+        ::unlink(options_.socketPath.c_str());
+    }
+    {
+        std::lock_guard<std::mutex> lock(subscribersMutex_);
+        for (int fd : subscribers_) {
+            ::close(fd);
+        }
+        subscribers_.clear();
+    }
+
+    if (segmentFd_ >= 0) {
+        ::fdatasync(segmentFd_);
+        ::close(segmentFd_);
+        segmentFd_ = -1;
+    }
+}
+
+void TranscriptSink::append(const std::string& record) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stop_) return;
+        pending_.push_back(record);
+    }
+    queueCondition_.notify_one();
+}
+
+void TranscriptSink::writerLoop() {
+    std::vector<std::string> batch;
+    bool retrying = false;
+    while (true) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            if (retrying) {
+                // Back off before retrying a batch that failed to commit
+                queueCondition_.wait_for(lock, std::chrono::milliseconds(kRetryIntervalMs), [this] { return stop_; });
+            } else {
+                queueCondition_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+                if (!stop_) {
+                    // Let concurrent finals accumulate so they share one commit
+                    queueCondition_.wait_for(lock, std::chrono::milliseconds(options_.flushIntervalMs),
+                        [this] { return stop_; });
+                }
+            }
+            stopping = stop_;
+            if (pending_.empty() && batch.empty() && stopping) {
+                return;
+            }
+            // A retried batch keeps its place ahead of newer records
+            batch.insert(batch.end(), std::make_move_iterator(pending_.begin()),
+                         std::make_move_iterator(pending_.end()));
+            pending_.clear();
+        }
+
+        if (!writeBatch(batch)) {
+            getGlobalLogger()->error("", "Transcript sink: failed to commit " + std::to_string(batch.size()) +
+                " records: " + std::strerror(errno) + (stopping ? " (dropped at shutdown)" : ", will retry"));
+            if (stopping) {
+                return;
+            }
+            retrying = true;
+            continue;
+        }
+        retrying = false;
+        committedRecords_ += batch.size();
+        // Subscribers only ever see committed records
+        publish(batch);
+        batch.clear();
+    }
+}
+
+bool TranscriptSink::openSegment() {
+    if (segmentFd_ >= 0) {
+        ::fdatasync(segmentFd_);
+        ::close(segmentFd_);
+        segmentFd_ = -1;
+    }
+
+    std::time_t now = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&now, &tm);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+    const std::string extension = options_.format == Format::BINARY ? ".bin" : ".jsonl";
+    const std::string path = options_.folder + "/transcripts-" + stamp + "-" +
+        std::to_string(segmentSeq_++) + extension;
+
+    segmentFd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (segmentFd_ < 0) {
+        getGlobalLogger()->error("", "Transcript sink: cannot open segment " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    segmentSize_ = 0;
+    getGlobalLogger()->info("", "Transcript sink segment: " + path);
+    return true;
+}
+
+std::string TranscriptSink::encode(const std::string& record) const {
+    if (options_.format == Format::JSONL) {
+        return record + "\n";
+    }
+    std::string frame;
+    frame.reserve(record.size() + 12);
+    putLe32(frame, kBinaryMagic);
+    putLe32(frame, static_cast<uint32_t>(record.size()));
+    putLe32(frame, crc32(record));
+    frame += record;
+    return frame;
+}
+
+bool TranscriptSink::writeBatch(const std::vector<std::string>& batch) {
+    std::string buffer;
+    for (const auto& record : batch) {
+        buffer += encode(record);
+    }
+
+    if (segmentFd_ < 0 || segmentSize_ + buffer.size() > options_.segmentBytes) {
+        if (!openSegment()) {
+            return false;
+        }
+    }
+
+    // Remember the last good end of the segment so a failed commit never
+    // leaves a torn record behind
+    off_t committedEnd = ::lseek(segmentFd_, 0, SEEK_END);
+    bool ok = committedEnd >= 0 && writeAll(segmentFd_, buffer.data(), buffer.size()) &&
+              (!options_.fsync || ::fdatasync(segmentFd_) == 0);
+    if (!ok) {
+        int savedErrno = errno;
+        if (committedEnd < 0 || ::ftruncate(segmentFd_, committedEnd) != 0) {
+            // Can't restore this segment; retry into a fresh one
+            ::close(segmentFd_);
+            segmentFd_ = -1;
+        }
+        errno = savedErrno;
+        return false;
+    }
+    segmentSize_ += buffer.size();
+    return true;
+}
+
+void TranscriptSink::publish(const std::vector<std::string>& batch) {
+    std::lock_guard<std::mutex> lock(subscribersMutex_);
+    if (subscribers_.empty()) return;
+
+    std::string lines;
+    for (const auto& record : batch) {
+        lines += record;
+        lines += '\n';
+    }
+
+    // Subscribers always receive JSONL; slow or closed ones are dropped
+    for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+        ssize_t n = ::send(*it, lines.data(), lines.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n != static_cast<ssize_t>(lines.size())) {
+            getGlobalLogger()->info("", "Transcript sink: dropping subscriber fd " + std::to_string(*it));
+            ::close(*it);
+            it = subscribers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TranscriptSink::acceptLoop() {
+    while (true) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // Listener shut down
+        }
+        std::lock_guard<std::mutex> lock(subscribersMutex_);
+        subscribers_.push_back(fd);
+        getGlobalLogger()->info("", "Transcript sink: subscriber connected (total: " +
+            std::to_string(subscribers_.size()) + ")");
+    }
+}
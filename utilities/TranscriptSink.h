@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// Durable, append-only log of final transcripts.
+//
+// Producers call append() with one serialized JSON record; a background
+// writer thread group-commits pending records to segmented files (one
+// write + fdatasync per batch) and then fans each committed batch out to
+// any subscribers connected on the optional Unix domain socket. A batch
+// that fails to commit is truncated off the segment and retried; it is
+// only published once it is on disk.
+//
+// JSONL segments hold one record per line. Binary segments hold frames of
+// [u32 magic][u32 length][u32 crc32][payload], little endian.
+class TranscriptSink {
+public:
+    enum class Format {
+        JSONL,
+        BINARY
+    };
+
+    struct Options {
+        std::string folder;               // Segment directory (required)
+        Format format = Format::JSONL;
+        size_t segmentBytes = 64 * 1024 * 1024;  // Rotate after this many bytes
+        int flushIntervalMs = 50;         // Max time a record waits for commit
+        bool fsync = true;                // fdatasync after every batch
+        std::string socketPath;           // Subscriber socket (empty = disabled)
+    };
+
+    explicit TranscriptSink(const Options& options);
+    ~TranscriptSink();
+
+    TranscriptSink(const TranscriptSink&) = delete;
+    TranscriptSink& operator=(const TranscriptSink&) = delete;
+
+    bool start();
+    void stop();
+
+    // Queue one record (a single-line JSON document) for commit.
+    void append(const std::string& record);
+
+    uint64_t committedRecords() const { return committedRecords_.load(); }
+
+    static Format parseFormat(const std::string& formatStr);
+
+private:
+    void writerLoop();
+    void acceptLoop();
+    bool openSegment();
+    bool writeBatch(const std::vector<std::string>& batch);
+    void publish(const std::vector<std::string>& batch);
+    std::string encode(const std::string& record) const;
+
+    Options options_;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCondition_;
+    std::vector<std::string> pending_;
+    bool stop_;
+
+    std::thread writer_;
+    int segmentFd_;
+    size_t segmentSize_;
+    uint32_t segmentSeq_;
+
+    std::thread acceptor_;
+    int listenFd_;
+    std::mutex subscribersMutex_;
+    std::vector<int> subscribers_;
+
+    std::atomic<uint64_t> committedRecords_;
+};